@@ -0,0 +1,21 @@
+movi $9400, r10
+movi $300, r1
+movi $0, r2
+fill: store r1, (r10 + r2)4
+addi $1, r2
+subi $1, r1
+jne fill
+movi $299, r1
+pass: movi $0, r2
+cmp_next: load r3, (r10 + r2)4
+load r4, 4(r10 + r2)4
+cmp r4, r3
+jle no_swap
+store r4, (r10 + r2)4
+store r3, 4(r10 + r2)4
+no_swap: addi $1, r2
+cmp r1, r2
+jl cmp_next
+subi $1, r1
+jne pass
+mem $16, r10
@@ -0,0 +1,12 @@
+movi $200000, r1
+movi $7, r2
+movi $1000003, r3
+loop: mov r3, r4
+div r2, r4
+mov r3, r5
+mod r2, r5
+mov r1, r6
+divu r2, r6
+add r5, r3
+subi $1, r1
+jne loop
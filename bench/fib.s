@@ -0,0 +1,18 @@
+movi $22, r1
+call fib
+jmp done
+fib: cmpi $2, r1
+jl base
+push r1
+subi $1, r1
+call fib
+push r2
+subi $1, r1
+call fib
+pop r3
+add r3, r2
+pop r1
+ret
+base: mov r1, r2
+ret
+done: mov r2, r9
@@ -0,0 +1,20 @@
+movi $9400, r10
+movi $2048, r4
+movi $0x55, r6
+mov r10, r5
+memset r6, r5, r4
+movi $11500, r11
+movi $2000, r7
+copy: mov r10, r1
+movi $11500, r3
+movi $2048, r4
+memcpy r1, r3, r4
+movi $0, r2
+movi $64, r8
+words: load r9, (r10 + r2)4
+store r9, (r11 + r2)4
+addi $1, r2
+subi $1, r8
+jne words
+subi $1, r7
+jne copy
@@ -0,0 +1,144 @@
+/*
+ * microbench.c: Microbenchmarks for the ALU, memory and instruction encoding
+ * helpers of the CPU simulator.
+ *
+ * Every primitive is called over a table of random inputs. The calls are timed
+ * in samples of CALLS_PER_SAMPLE calls, after WARMUP_SAMPLES untimed samples,
+ * and the median and 99th percentile cycles per call are reported as one line
+ * of key=value pairs per primitive. The loop_overhead line is the cost of the
+ * timing loop itself and is included in every other line.
+ *
+ * Cycles are read from the time stamp counter on x86 hosts, and are
+ * nanoseconds elsewhere.
+ */
+
+#define CPU_NO_MAIN
+#include "../cpu_main.c"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define readCycles()    __rdtsc()
+#else
+static inline uint64_t
+readCycles() {
+    return (uint64_t) getTimeInNanoseconds();
+}
+#endif
+
+#define NUM_INPUTS          1024        // Must be a power of 2
+#define CALLS_PER_SAMPLE    64
+#define NUM_SAMPLES         5000
+#define WARMUP_SAMPLES      500
+
+SIZE_TYPE input1[NUM_INPUTS];
+SIZE_TYPE input2[NUM_INPUTS];
+SIZE_TYPE addresses[NUM_INPUTS];
+SIZE_TYPE binary_opcodes[NUM_INPUTS];
+struct instruction_attr instr_attrs[NUM_INPUTS];
+
+// Results are accumulated here so that the calls are not optimised out.
+volatile SIZE_TYPE sink;
+
+/*
+ * xorshift pseudo random number generator, seeded with a fixed value so that
+ * every run uses the same inputs.
+ */
+uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+uint64_t
+nextRandom() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+int
+compareSamples(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Function to print the median and 99th percentile cycles per call of the
+ * collected samples.
+ */
+void
+reportSamples(const char *name, uint64_t *samples) {
+    qsort(samples, NUM_SAMPLES, sizeof(samples[0]), compareSamples);
+    printf("primitive=%s median_cycles=%.2f p99_cycles=%.2f\n", name,
+            (double) samples[NUM_SAMPLES / 2] / CALLS_PER_SAMPLE,
+            (double) samples[NUM_SAMPLES * 99 / 100] / CALLS_PER_SAMPLE);
+}
+
+/*
+ * Times expr, which can use the input index i, and reports the result.
+ */
+#define MICROBENCH(name, expr) do {                                             \
+    static uint64_t samples[NUM_SAMPLES];                                       \
+    int s, j;                                                                   \
+    for (s = -WARMUP_SAMPLES; s < NUM_SAMPLES; s++) {                           \
+        uint64_t start = readCycles();                                          \
+        for (j = 0; j < CALLS_PER_SAMPLE; j++) {                                \
+            int i = (s * CALLS_PER_SAMPLE + j) & (NUM_INPUTS - 1);              \
+            sink = sink + (SIZE_TYPE) (expr);                                   \
+        }                                                                       \
+        uint64_t end = readCycles();                                            \
+        if (s >= 0) {                                                           \
+            samples[s] = end - start;                                           \
+        }                                                                       \
+    }                                                                           \
+    reportSamples(name, samples);                                               \
+} while (0)
+
+/*
+ * Function to fill the input tables. The instructions to encode/decode are a
+ * mix of the common instruction formats with random registers.
+ */
+void
+initializeInputs() {
+    const char *instructions[] = {ADD, LOAD, ADDI, JNE, MOVI};
+    const opcode_formats formats[] = {REG_REG, LOAD_STORE, IMM_REG, CONTROL_LABEL, MOV_IMM_REG};
+    int i;
+
+    for (i = 0; i < NUM_INPUTS; i++) {
+        input1[i] = (SIZE_TYPE) nextRandom();
+        // Non-zero divisor
+        input2[i] = (SIZE_TYPE) nextRandom() | 1;
+        addresses[i] = DATA_MEMORY_MIN + nextRandom() % (DATA_MEMORY_SIZE - NUM_BYTES_IN_WORD);
+
+        int kind = nextRandom() % 5;
+        struct instruction_attr *attr = &instr_attrs[i];
+        memset(attr, 0, sizeof(*attr));
+        strcpy(attr->instruction, instructions[kind]);
+        attr->format = formats[kind];
+        attr->operand_register = nextRandom() % MAX_GPRS;
+        attr->base_register = nextRandom() % MAX_GPRS;
+        attr->index_register = nextRandom() % MAX_GPRS;
+        attr->scale = 4;
+        attr->offset = (signed char) nextRandom();
+        attr->const_or_label = (signed char) nextRandom();
+        binary_opcodes[i] = encodeInstructionToBinary(attr);
+    }
+}
+
+int main() {
+    struct instruction_attr decoded;
+
+    initializeInputs();
+
+    MICROBENCH("loop_overhead", input1[i]);
+    MICROBENCH("add", add(input1[i], input2[i]));
+    MICROBENCH("subtract", subtract(input1[i], input2[i]));
+    MICROBENCH("multiply", multiply(input1[i], input2[i]));
+    MICROBENCH("divide", divide(input1[i], input2[i]));
+    MICROBENCH("sra", sra(input1[i] & (WORD_SIZE - 1), input2[i]));
+    MICROBENCH("setFlagsRegister", (setFlagsRegister(input1[i], input2[i], input1[i] + input2[i]), FLAGS));
+    MICROBENCH("readFromMemory", readFromMemory(addresses[i], NUM_BYTES_IN_WORD));
+    MICROBENCH("writeIntoMemory", (writeIntoMemory(addresses[i], NUM_BYTES_IN_WORD, (data_ptr) &input1[i]), 0));
+    MICROBENCH("decodeInstructionFromBinary", (decodeInstructionFromBinary(binary_opcodes[i], &decoded),
+                decoded.operand_register));
+    MICROBENCH("encodeInstructionToBinary", encodeInstructionToBinary(&instr_attrs[i]));
+    return 0;
+}
@@ -0,0 +1,9 @@
+movi $500, r1
+outer: movi $500, r2
+inner: add r2, r3
+addi $1, r4
+xor r3, r5
+subi $1, r2
+jne inner
+subi $1, r1
+jne outer
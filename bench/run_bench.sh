@@ -0,0 +1,27 @@
+#!/bin/sh
+##*****************************************************************************
+## Runs every benchmark program in this directory with the fast interpreter,
+## discarding the simulator output, and prints one line of key=value results
+## per program:
+##
+##   benchmark=<name> instructions=<n> elapsed_ns=<n> ns_per_instruction=<n>
+##   instructions_per_second=<n> peak_rss_kb=<n>
+##
+## Usage: run_bench.sh [simulator binary, default ./cpu]
+##*****************************************************************************
+
+CPU=${1:-./cpu}
+BENCH_DIR=$(dirname "$0")
+status=0
+
+for program in "$BENCH_DIR"/*.s; do
+    name=$(basename "$program" .s)
+    stats=$("$CPU" -i fast -s "$program" 2>&1 >/dev/null | grep '^instructions=')
+    if [ -z "$stats" ]; then
+        echo "benchmark=$name status=failed"
+        status=1
+    else
+        echo "benchmark=$name $stats"
+    fi
+done
+exit $status
@@ -0,0 +1,214 @@
+/*
+ * cpu_cache.c: On-disk cache of assembled programs.
+ *
+ * Programs are keyed by a hash of their source text and the word size. A cache
+ * entry holds the instruction memory image and the label table, which is all
+ * the assembler produces, so a cache hit skips assembly entirely. The entry
+ * also keeps a copy of the source, which is compared on load so two programs
+ * whose hashes collide never share an entry. Entries are written to a
+ * temporary file and renamed into place, so concurrent runs never see a
+ * partial entry.
+ *
+ * A cache hit skips the assembly listing, so the cache is only used when it is
+ * asked for. The cache directory is $CPU_CACHE_DIR, or $HOME/.cache/cpu_sim.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+
+// Bumped whenever the instruction encoding or the entry layout changes.
+#define CACHE_FORMAT_VERSION    2
+#define CACHE_MAGIC             0x48434143  // "CACH"
+
+struct cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t word_size;
+    uint32_t label_count;
+    uint64_t source_hash;
+    uint64_t source_size;
+    uint64_t image_size;
+};
+
+typedef enum {CACHE_BYPASS, CACHE_HIT, CACHE_MISS} cache_results;
+const char *cache_result_names[] = {"bypass", "hit", "miss"};
+
+/*
+ * Returns the 64-bit FNV-1a hash of the given bytes.
+ */
+uint64_t
+hashSource(const char *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+    for (i = 0; i < size; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*
+ * Returns true if the cache is enabled by pointing $CPU_CACHE_DIR at a directory.
+ */
+bool
+isCacheDirectorySet() {
+    const char *dir = getenv("CPU_CACHE_DIR");
+    return dir != NULL && dir[0] != '\0';
+}
+
+/*
+ * Returns true if the next size bytes of the file are the given bytes.
+ */
+bool
+matchCachedSource(FILE *fp, const char *data, size_t size) {
+    char buffer[4096];
+    while (size > 0) {
+        size_t count = size < sizeof(buffer) ? size : sizeof(buffer);
+        if (fread(buffer, 1, count, fp) != count || memcmp(buffer, data, count) != 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+/*
+ * Function to get the cache directory into path, creating it if needed.
+ *
+ * Returns false if there is no usable cache directory.
+ */
+bool
+getCacheDirectory(char *path, int size) {
+    const char *dir = getenv("CPU_CACHE_DIR");
+    if (dir != NULL && dir[0] != '\0') {
+        snprintf(path, size, "%s", dir);
+    } else {
+        const char *home = getenv("HOME");
+        if (home == NULL || home[0] == '\0') {
+            return false;
+        }
+        snprintf(path, size, "%s/.cache", home);
+        if (mkdir(path, 0755) == -1 && errno != EEXIST) {
+            return false;
+        }
+        snprintf(path, size, "%s/.cache/cpu_sim", home);
+    }
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+/*
+ * Function to get the path of the cache entry for the given source hash.
+ */
+bool
+getCacheEntryPath(uint64_t source_hash, char *path, int size) {
+    char dir[PATH_MAX];
+    if (!getCacheDirectory(dir, sizeof(dir))) {
+        return false;
+    }
+    snprintf(path, size, "%s/%016llx-w%d.img", dir, (unsigned long long) source_hash, WORD_SIZE);
+    return true;
+}
+
+/*
+ * Function to load the assembled program of the given source from the cache
+ * into instruction memory and the label table.
+ *
+ * Returns false if there is no valid entry for the source, or the entry was
+ * made for a different source with the same hash.
+ */
+bool
+loadProgramFromCache(struct source_buffer *source, uint64_t source_hash) {
+    char path[PATH_MAX];
+    if (!getCacheEntryPath(source_hash, path, sizeof(path))) {
+        return false;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+
+    struct cache_header header;
+    bool valid = fread(&header, sizeof(header), 1, fp) == 1
+        && header.magic == CACHE_MAGIC
+        && header.version == CACHE_FORMAT_VERSION
+        && header.word_size == WORD_SIZE
+        && header.source_hash == source_hash
+        && header.source_size == source->size
+        && header.image_size <= INSTRUCTION_MEMORY_SIZE
+        && header.label_count <= TOTAL_LABELS
+        && fread(&MEMORY[INSTRUCTION_MEMORY_MIN], 1, header.image_size, fp) == header.image_size
+        && fread(LABELS, sizeof(LABELS[0]), header.label_count, fp) == header.label_count
+        && matchCachedSource(fp, source->data, source->size);
+    fclose(fp);
+
+    if (!valid) {
+        // Leave no partly loaded program behind.
+        memset(&MEMORY[INSTRUCTION_MEMORY_MIN], 0, INSTRUCTION_MEMORY_SIZE);
+        return false;
+    }
+    INSTR_MEMORY_PTR = INSTRUCTION_MEMORY_MIN + header.image_size;
+    LABEL_COUNT = header.label_count;
+    return true;
+}
+
+/*
+ * Function to save the assembled program of the given source to the cache.
+ * Failing to write the cache is not an error.
+ */
+void
+saveProgramToCache(struct source_buffer *source, uint64_t source_hash) {
+    char path[PATH_MAX];
+    char temp_path[PATH_MAX + 32];
+    if (!getCacheEntryPath(source_hash, path, sizeof(path))) {
+        return;
+    }
+    snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", path, (int) getpid());
+    FILE *fp = fopen(temp_path, "wb");
+    if (fp == NULL) {
+        return;
+    }
+
+    struct cache_header header = {CACHE_MAGIC, CACHE_FORMAT_VERSION, WORD_SIZE, LABEL_COUNT,
+        source_hash, source->size, INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN};
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+        && fwrite(&MEMORY[INSTRUCTION_MEMORY_MIN], 1, header.image_size, fp) == header.image_size
+        && fwrite(LABELS, sizeof(LABELS[0]), header.label_count, fp) == header.label_count
+        && fwrite(source->data, 1, source->size, fp) == source->size;
+    if (fclose(fp) != 0 || !written || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+    }
+}
+
+/*
+ * Function to remove all entries from the cache directory.
+ */
+void
+clearProgramCache() {
+    char dir[PATH_MAX];
+    char path[PATH_MAX + 256];
+    if (!getCacheDirectory(dir, sizeof(dir))) {
+        return;
+    }
+    DIR *dp = opendir(dir);
+    if (dp == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dp)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len > 4 && strcmp(&entry->d_name[len - 4], ".img") == 0) {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dp);
+}
+
+/*
+ * Function to print the cache result as a line of key=value pairs on stderr.
+ */
+void
+displayCacheStats(cache_results result, uint64_t source_hash) {
+    fprintf(stderr, "assembly_cache=%s key=%016llx\n", cache_result_names[result],
+            (unsigned long long) source_hash);
+}
@@ -0,0 +1,318 @@
+/*
+ * cpu_cfg.c: Control flow graph of the program in instruction memory.
+ *
+ * The instructions decoded by decodeProgramInstructions are split into basic
+ * blocks. A block starts at the first instruction, at every jump target and
+ * label, and after every control transfer instruction, ret and zero word. The
+ * edges are:
+ *  - fall through into the next block
+ *  - jump from a jmp/jcc/loop to its target
+ *  - call from a call to the called block
+ *  - return from a block ending in ret to the block after every call
+ * A block that can leave the program, by reaching a zero word or jumping
+ * outside of it, is marked as an exit. A ret is an exit when there is no call.
+ */
+
+typedef enum {EDGE_FALL_THROUGH, EDGE_JUMP, EDGE_CALL, EDGE_RETURN} cfg_edge_kinds;
+const char *cfg_edge_kind_names[] = {"fall_through", "jump", "call", "return"};
+
+struct basic_block {
+    int first_instruction;      // Index in PROGRAM_INSTRUCTIONS
+    int end_instruction;        // One past the last instruction of the block
+    bool is_exit;
+};
+
+struct cfg_edge {
+    int from_block;
+    int to_block;
+    cfg_edge_kinds kind;
+};
+
+// Every ret has an edge to every return site, so programs with many calls and
+// rets can run out of edges. See addCfgEdge.
+#define MAX_CFG_EDGES   (4 * TOTAL_INSTRUCTION_SLOTS)
+
+int CFG_INSTRUCTION_COUNT = 0;
+int CFG_BLOCK_COUNT = 0;
+int CFG_EDGE_COUNT = 0;
+struct basic_block CFG_BLOCKS[TOTAL_INSTRUCTION_SLOTS];
+struct cfg_edge CFG_EDGES[MAX_CFG_EDGES];
+
+// Block starting at each instruction memory word, or -1.
+int CFG_BLOCK_AT_WORD[TOTAL_INSTRUCTION_SLOTS + 1];
+
+/*
+ * Function to add an edge to the CFG. An edge that does not fit is replaced
+ * by marking its source block as an exit, which is the conservative choice
+ * for the analyses.
+ */
+void
+addCfgEdge(int from_block, int to_block, cfg_edge_kinds kind) {
+    if (CFG_EDGE_COUNT == MAX_CFG_EDGES) {
+        CFG_BLOCKS[from_block].is_exit = true;
+        return;
+    }
+    CFG_EDGES[CFG_EDGE_COUNT].from_block = from_block;
+    CFG_EDGES[CFG_EDGE_COUNT].to_block = to_block;
+    CFG_EDGES[CFG_EDGE_COUNT].kind = kind;
+    CFG_EDGE_COUNT++;
+}
+
+/*
+ * Function to add an edge to the block starting at the given word, or to mark
+ * the block as an exit if no block starts there.
+ */
+void
+addCfgEdgeToWord(int from_block, int word, cfg_edge_kinds kind) {
+    int total_words = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    if (word < 0 || word > total_words || CFG_BLOCK_AT_WORD[word] == -1) {
+        CFG_BLOCKS[from_block].is_exit = true;
+        return;
+    }
+    addCfgEdge(from_block, CFG_BLOCK_AT_WORD[word], kind);
+}
+
+/*
+ * Returns true if the instruction ends its basic block.
+ */
+bool
+endsBasicBlock(struct program_instruction *instr) {
+    return instr->binary_opcode == 0
+        || instr->instr_attr.format == CONTROL_LABEL
+        || strcmp(instr->instr_attr.instruction, RET) == 0;
+}
+
+/*
+ * Function to build the CFG of the program in instruction memory.
+ */
+void
+buildControlFlowGraph() {
+    int total_words = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    int count = decodeProgramInstructions();
+    bool is_leader[TOTAL_INSTRUCTION_SLOTS + 1] = {false};
+    int i;
+
+    // Find the first word of every block.
+    is_leader[0] = true;
+    for (i = 0; i < LABEL_COUNT; i++) {
+        if (LABELS[i].position >= 0 && LABELS[i].position <= total_words) {
+            is_leader[LABELS[i].position] = true;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        if (!endsBasicBlock(instr)) {
+            continue;
+        }
+        is_leader[instr->position + instr->size] = true;
+        if (instr->binary_opcode != 0 && instr->instr_attr.format == CONTROL_LABEL) {
+            int target = getJumpTarget(instr);
+            if (target >= 0 && target <= total_words) {
+                is_leader[target] = true;
+            }
+        }
+    }
+
+    // Split the instructions into blocks. A leader inside an extension word is
+    // not an instruction, and is left without a block.
+    CFG_INSTRUCTION_COUNT = count;
+    CFG_BLOCK_COUNT = 0;
+    CFG_EDGE_COUNT = 0;
+    for (i = 0; i <= total_words; i++) {
+        CFG_BLOCK_AT_WORD[i] = -1;
+    }
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        if (i == 0 || is_leader[instr->position]) {
+            CFG_BLOCKS[CFG_BLOCK_COUNT].first_instruction = i;
+            CFG_BLOCKS[CFG_BLOCK_COUNT].is_exit = false;
+            CFG_BLOCK_AT_WORD[instr->position] = CFG_BLOCK_COUNT;
+            CFG_BLOCK_COUNT++;
+        }
+        CFG_BLOCKS[CFG_BLOCK_COUNT - 1].end_instruction = i + 1;
+    }
+
+    // Return sites are the words following the calls.
+    int return_sites[TOTAL_INSTRUCTION_SLOTS];
+    int return_site_count = 0;
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        if (instr->binary_opcode != 0 && strcmp(instr->instr_attr.instruction, CALL) == 0) {
+            return_sites[return_site_count++] = instr->position + instr->size;
+        }
+    }
+
+    int b;
+    for (b = 0; b < CFG_BLOCK_COUNT; b++) {
+        struct program_instruction *last = &PROGRAM_INSTRUCTIONS[CFG_BLOCKS[b].end_instruction - 1];
+        struct instruction_attr *attr = &last->instr_attr;
+        int next_word = last->position + last->size;
+
+        if (last->binary_opcode == 0) {
+            CFG_BLOCKS[b].is_exit = true;
+        } else if (strcmp(attr->instruction, RET) == 0) {
+            if (return_site_count == 0) {
+                CFG_BLOCKS[b].is_exit = true;
+            }
+            for (i = 0; i < return_site_count; i++) {
+                addCfgEdgeToWord(b, return_sites[i], EDGE_RETURN);
+            }
+        } else if (strcmp(attr->instruction, CALL) == 0) {
+            addCfgEdgeToWord(b, getJumpTarget(last), EDGE_CALL);
+        } else if (attr->format == CONTROL_LABEL) {
+            addCfgEdgeToWord(b, getJumpTarget(last), EDGE_JUMP);
+            if (strcmp(attr->instruction, JMP) != 0) {
+                addCfgEdgeToWord(b, next_word, EDGE_FALL_THROUGH);
+            }
+        } else {
+            // Falling off the end of the program reaches a zero word, which
+            // makes the block an exit.
+            addCfgEdgeToWord(b, next_word, EDGE_FALL_THROUGH);
+        }
+    }
+}
+
+/*
+ * Returns true if a label is defined at the start of the block.
+ */
+bool
+hasBlockLabels(struct basic_block *block) {
+    int position = PROGRAM_INSTRUCTIONS[block->first_instruction].position;
+    int i;
+    for (i = 0; i < LABEL_COUNT; i++) {
+        if (LABELS[i].position == position) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Function to write the labels of the block to the file, each one printed
+ * with format and separated by sep.
+ */
+void
+writeBlockLabels(FILE *fp, struct basic_block *block, const char *format, const char *sep) {
+    int position = PROGRAM_INSTRUCTIONS[block->first_instruction].position;
+    bool first = true;
+    int i;
+    for (i = 0; i < LABEL_COUNT; i++) {
+        if (LABELS[i].position == position) {
+            fprintf(fp, "%s", first ? "" : sep);
+            fprintf(fp, format, LABELS[i].label);
+            first = false;
+        }
+    }
+}
+
+/*
+ * Returns the instruction memory address of the instruction.
+ */
+SIZE_TYPE
+getProgramInstructionAddress(struct program_instruction *instr) {
+    return INSTRUCTION_MEMORY_MIN + instr->position * INSTR_SIZE;
+}
+
+/*
+ * Returns the mnemonic of the instruction, "end" for a zero word.
+ */
+const char *
+getProgramInstructionName(struct program_instruction *instr) {
+    return instr->binary_opcode == 0 ? "end" : instr->instr_attr.instruction;
+}
+
+/*
+ * Function to write the CFG in Graphviz DOT format. Every block lists its
+ * labels and instructions, and its execution count if with_counts is set.
+ * Exit blocks are drawn with a double border.
+ */
+void
+writeControlFlowGraphDot(FILE *fp, bool with_counts) {
+    int b, i;
+    fprintf(fp, "digraph cfg {\n");
+    fprintf(fp, "    node [shape=box, fontname=\"monospace\"];\n");
+    for (b = 0; b < CFG_BLOCK_COUNT; b++) {
+        struct basic_block *block = &CFG_BLOCKS[b];
+        fprintf(fp, "    B%d [label=\"B%d", b, b);
+        if (hasBlockLabels(block)) {
+            fprintf(fp, " (");
+            writeBlockLabels(fp, block, "%s", ", ");
+            fprintf(fp, ")");
+        }
+        if (with_counts) {
+            int position = PROGRAM_INSTRUCTIONS[block->first_instruction].position;
+            fprintf(fp, "\\ncount: %lu", PROFILE_ADDRESS_COUNTS[position]);
+        }
+        fprintf(fp, "\\n");
+        for (i = block->first_instruction; i < block->end_instruction; i++) {
+            fprintf(fp, "0x%" PRIxW ": %s\\l", getProgramInstructionAddress(&PROGRAM_INSTRUCTIONS[i]),
+                    getProgramInstructionName(&PROGRAM_INSTRUCTIONS[i]));
+        }
+        fprintf(fp, "\"%s];\n", block->is_exit ? ", peripheries=2" : "");
+    }
+    for (i = 0; i < CFG_EDGE_COUNT; i++) {
+        fprintf(fp, "    B%d -> B%d [label=\"%s\"%s];\n", CFG_EDGES[i].from_block, CFG_EDGES[i].to_block,
+                cfg_edge_kind_names[CFG_EDGES[i].kind],
+                CFG_EDGES[i].kind == EDGE_FALL_THROUGH ? "" : ", style=dashed");
+    }
+    fprintf(fp, "}\n");
+}
+
+/*
+ * Function to write the CFG as JSON:
+ *  {"blocks": [{"id", "start", "end", "labels", "instructions", "exit"[, "count"]}...],
+ *   "edges": [{"from", "to", "kind"}...]}
+ * start and end are the instruction memory address range of the block.
+ */
+void
+writeControlFlowGraphJson(FILE *fp, bool with_counts) {
+    int b, i;
+    fprintf(fp, "{\n  \"blocks\": [");
+    for (b = 0; b < CFG_BLOCK_COUNT; b++) {
+        struct basic_block *block = &CFG_BLOCKS[b];
+        struct program_instruction *first = &PROGRAM_INSTRUCTIONS[block->first_instruction];
+        struct program_instruction *last = &PROGRAM_INSTRUCTIONS[block->end_instruction - 1];
+        fprintf(fp, "%s\n    {\"id\": %d, \"start\": %" PRIuW ", \"end\": %" PRIuW ", \"labels\": [",
+                b == 0 ? "" : ",", b, getProgramInstructionAddress(first),
+                getProgramInstructionAddress(last) + last->size * INSTR_SIZE);
+        writeBlockLabels(fp, block, "\"%s\"", ", ");
+        fprintf(fp, "], \"instructions\": [");
+        for (i = block->first_instruction; i < block->end_instruction; i++) {
+            fprintf(fp, "%s\"%s\"", i == block->first_instruction ? "" : ", ",
+                    getProgramInstructionName(&PROGRAM_INSTRUCTIONS[i]));
+        }
+        fprintf(fp, "], \"exit\": %s", block->is_exit ? "true" : "false");
+        if (with_counts) {
+            fprintf(fp, ", \"count\": %lu", PROFILE_ADDRESS_COUNTS[first->position]);
+        }
+        fprintf(fp, "}");
+    }
+    fprintf(fp, "\n  ],\n  \"edges\": [");
+    for (i = 0; i < CFG_EDGE_COUNT; i++) {
+        fprintf(fp, "%s\n    {\"from\": %d, \"to\": %d, \"kind\": \"%s\"}", i == 0 ? "" : ",",
+                CFG_EDGES[i].from_block, CFG_EDGES[i].to_block, cfg_edge_kind_names[CFG_EDGES[i].kind]);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+/*
+ * Function to build the CFG of the program and export it to the given file,
+ * as JSON if the file name ends with ".json" and as DOT otherwise.
+ */
+void
+exportControlFlowGraph(const char *file_name, bool with_counts) {
+    buildControlFlowGraph();
+    FILE *fp = fopen(file_name, "w");
+    if (fp == NULL) {
+        printf("ERROR: Cannot create CFG file '%s'.\n", file_name);
+        exit(EXIT_FAILURE);
+    }
+    size_t len = strlen(file_name);
+    if (len > 5 && strcmp(&file_name[len - 5], ".json") == 0) {
+        writeControlFlowGraphJson(fp, with_counts);
+    } else {
+        writeControlFlowGraphDot(fp, with_counts);
+    }
+    fclose(fp);
+    printf("Wrote CFG with %d blocks and %d edges to '%s'.\n", CFG_BLOCK_COUNT, CFG_EDGE_COUNT, file_name);
+}
@@ -7,16 +7,25 @@
 #define CPU_HEAD
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <limits.h>
+#include <inttypes.h>
 
-// Defining word size for CPU
+// Defining word size for CPU. The 64-bit simulator is built with
+// -DWORD_SIZE=64.
+#ifndef WORD_SIZE
 #define WORD_SIZE 32
+#endif
+
+#if WORD_SIZE != 32 && WORD_SIZE != 64
+#error "WORD_SIZE must be 32 or 64"
+#endif
 
 // Define a constant for byte size
 #define BYTE_SIZE   8
 
 // Define number of bytes in CPU word
-#define NUM_BYTES_IN_WORD WORD_SIZE/BYTE_SIZE
+#define NUM_BYTES_IN_WORD (WORD_SIZE/BYTE_SIZE)
 
 // Define maximum number of General Purpose Registers
 #define MAX_GPRS	16
@@ -43,8 +52,31 @@
 #define SIZE_64     uint64_t
 
 // Define the data type size to be used for declaring all registers based on
-// word size
+// word size, along with the signed view of a register, the double width types
+// holding a full product in HI:LO and the printf formats of a register.
+#if WORD_SIZE == 64
+#define SIZE_TYPE SIZE_64
+#define SIGNED_SIZE_TYPE        int64_t
+#define DOUBLE_SIZE_TYPE        unsigned __int128
+#define SIGNED_DOUBLE_SIZE_TYPE __int128
+#define PRIxW   PRIx64
+#define PRIuW   PRIu64
+#define PRIdW   PRId64
+#else
 #define SIZE_TYPE SIZE_32
+#define SIGNED_SIZE_TYPE        int32_t
+#define DOUBLE_SIZE_TYPE        uint64_t
+#define SIGNED_DOUBLE_SIZE_TYPE int64_t
+#define PRIxW   PRIx32
+#define PRIuW   PRIu32
+#define PRIdW   PRId32
+#endif
+
+// Size of an encoded instruction in bytes. Instructions are 32 bits wide for
+// every word size; the extension word holding a wide immediate constant is a
+// full register wide and takes IMM_EXT_WORDS instruction slots.
+#define INSTR_SIZE      4
+#define IMM_EXT_WORDS   (NUM_BYTES_IN_WORD / INSTR_SIZE)
 
 
 // Define the memory size based on WORD_SIZE
@@ -71,6 +103,11 @@
 // Declare global registers
 SIZE_TYPE GPRS[MAX_GPRS];
 
+// Define maximum number of Floating Point Registers. Single precision values
+// are held in the double precision registers after rounding to single.
+#define MAX_FPRS    16
+double FPRS[MAX_FPRS];
+
 
 // Define the SP and FP
 #define SP  GPRS[14]
@@ -95,6 +132,11 @@ INIT_SPRS(SIZE_TYPE);
 #define LEA		"lea"
 #define MOV     "mov"
 #define MOVI    "movi"
+#define LUI     "lui"
+#define MEMCPY  "memcpy"
+#define MEMSET  "memset"
+#define VLOAD   "vload"
+#define VSTORE  "vstore"
 
 // ALU instructions
 #define ADD		"add"
@@ -124,6 +166,23 @@ INIT_SPRS(SIZE_TYPE);
 #define SRA     "sra"
 #define SRAI    "srai"
 #define NOT 	"not"
+#define POPCNT  "popcnt"
+#define CLZ     "clz"
+#define CTZ     "ctz"
+#define BSWAP   "bswap"
+#define ROL     "rol"
+#define ROR     "ror"
+#define ROLI    "roli"
+#define RORI    "rori"
+#define MULT    "mult"
+#define MULTU   "multu"
+#define DIVU    "divu"
+#define MFHI    "mfhi"
+#define MFLO    "mflo"
+#define CMP     "cmp"
+#define CMPI    "cmpi"
+#define TEST    "test"
+#define TESTI   "testi"
 
 #define SLTU    "sltu"
 // Branching instructions
@@ -136,6 +195,54 @@ INIT_SPRS(SIZE_TYPE);
 #define JGE     "jge"
 #define JL      "jl"
 #define JLE     "jle"
+#define LOOP    "loop"
+// Packed (SIMD) instructions on 8-bit(.b)/16-bit(.h) lanes of a register
+#define PADDB   "padd.b"
+#define PADDH   "padd.h"
+#define PSUBB   "psub.b"
+#define PSUBH   "psub.h"
+#define PADDUSB "paddus.b"
+#define PADDUSH "paddus.h"
+#define PSUBUSB "psubus.b"
+#define PSUBUSH "psubus.h"
+#define PCMPEQB "pcmpeq.b"
+#define PCMPEQH "pcmpeq.h"
+#define PCMPGTB "pcmpgt.b"
+#define PCMPGTH "pcmpgt.h"
+#define PSHUFB  "pshufb"
+// Floating point instructions on single(.s)/double(.d) precision values
+#define FLOADS  "fload.s"
+#define FLOADD  "fload.d"
+#define FSTORES "fstore.s"
+#define FSTORED "fstore.d"
+#define FADDS   "fadd.s"
+#define FADDD   "fadd.d"
+#define FSUBS   "fsub.s"
+#define FSUBD   "fsub.d"
+#define FMULS   "fmul.s"
+#define FMULD   "fmul.d"
+#define FDIVS   "fdiv.s"
+#define FDIVD   "fdiv.d"
+#define FSQRTS  "fsqrt.s"
+#define FSQRTD  "fsqrt.d"
+#define FCMPS   "fcmp.s"
+#define FCMPD   "fcmp.d"
+// Conversions, named fcvt.<dest>.<src> with w being a signed integer register
+#define FCVTSW  "fcvt.s.w"
+#define FCVTDW  "fcvt.d.w"
+#define FCVTWS  "fcvt.w.s"
+#define FCVTWD  "fcvt.w.d"
+#define FCVTSD  "fcvt.s.d"
+#define FCVTDS  "fcvt.d.s"
+// Conditional move instructions
+#define CMOVE   "cmove"
+#define CMOVNE  "cmovne"
+#define CMOVS   "cmovs"
+#define CMOVNS  "cmovns"
+#define CMOVG   "cmovg"
+#define CMOVGE  "cmovge"
+#define CMOVL   "cmovl"
+#define CMOVLE  "cmovle"
 // Procedure call instructions
 #define RET     "ret"
 #define CALL    "call"
@@ -148,27 +255,53 @@ INIT_SPRS(SIZE_TYPE);
 const char *valid_registers[] = {"r0", "r1", "r2", "r3", "r4", "r5", "r6", \
 	"r7", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "mdr", "mar"};
 
+// Define supported floating point register names
+const char *valid_float_registers[] = {"f0", "f1", "f2", "f3", "f4", "f5", "f6", \
+	"f7", "f8", "f9", "f10", "f11", "f12", "f13", "f14", "f15"};
+
 // Define supported opcodes
 const char *valid_instructions[] = {LOAD, STORE, MEM, LEA, ADD, AND, ADDI, SUB, \
     SUBI, DIV, DIVI, MUL, MULI, MOD, MODI, AND, ANDI, OR, ORI, XOR, XORI, \
     NOR, NORI, SLT, SLTI, SLL, SLLI, SRL, SRLI, SRA, SRAI, SLTU, JMP, JE, JNE,\
-    JS, JNS, JG, JGE, JL, JLE, RET, CALL, PUSH, POP, NOT, MOVI, MOV};
+    JS, JNS, JG, JGE, JL, JLE, RET, CALL, PUSH, POP, NOT, MOVI, MOV, LUI,\
+    CMP, CMPI, TEST, TESTI, CMOVE, CMOVNE, CMOVS, CMOVNS, CMOVG, CMOVGE, CMOVL,\
+    CMOVLE, MEMCPY, MEMSET, VLOAD, VSTORE, PADDB, PADDH, PSUBB, PSUBH, PADDUSB,\
+    PADDUSH, PSUBUSB, PSUBUSH, PCMPEQB, PCMPEQH, PCMPGTB, PCMPGTH, PSHUFB,\
+    POPCNT, CLZ, CTZ, BSWAP, ROL, ROR, ROLI, RORI, MULT, MULTU, DIVU, MFHI, MFLO,\
+    LOOP, FLOADS, FLOADD, FSTORES, FSTORED, FADDS, FADDD, FSUBS, FSUBD, FMULS, FMULD,\
+    FDIVS, FDIVD, FSQRTS, FSQRTD, FCMPS, FCMPD, FCVTSW, FCVTDW, FCVTWS, FCVTWD,\
+    FCVTSD, FCVTDS};
 
 // Define number of valid register names
 const int NUM_VALID_REGISTERS = sizeof(valid_registers)/sizeof(valid_registers[0]);
+const int NUM_VALID_FLOAT_REGISTERS = sizeof(valid_float_registers)/sizeof(valid_float_registers[0]);
 
 // Define number of valid cpu operations
 const int NUM_VALID_OPCODES = sizeof(valid_instructions)/sizeof(valid_instructions[0]);
 
 // Define different categories instructions
-const char *R_INSTR[] = {NOT, AND, OR, XOR, ADD, SUB, DIV, MUL, MOD, NOR, SLT, SLL, SRL, SRA, SLTU};
-const char *I_INSTR[] = {ADDI, SUBI, DIVI, MULI, MODI, ANDI, ORI, XORI, NORI, SLTI, SLLI, SRLI, SRAI};
-const char *MEM_INSTR[] = {LOAD, STORE, LEA};
-const char *CONTROL_INSTR[] = {JMP, JE, JNE, JS, JNS, JG, JGE, JL, JLE, CALL};
+const char *R_INSTR[] = {NOT, AND, OR, XOR, ADD, SUB, DIV, MUL, MOD, NOR, SLT, SLL, SRL, SRA, SLTU, CMP, TEST,
+    POPCNT, CLZ, CTZ, BSWAP, ROL, ROR, MULT, MULTU, DIVU};
+const char *I_INSTR[] = {ADDI, SUBI, DIVI, MULI, MODI, ANDI, ORI, XORI, NORI, SLTI, SLLI, SRLI, SRAI, CMPI, TESTI,
+    ROLI, RORI};
+const char *MEM_INSTR[] = {LOAD, STORE, LEA, VLOAD, VSTORE, FLOADS, FLOADD, FSTORES, FSTORED};
+const char *CONTROL_INSTR[] = {JMP, JE, JNE, JS, JNS, JG, JGE, JL, JLE, CALL, LOOP};
 const char *STACK_INSTR[] = {PUSH, POP};
+const char *HILO_INSTR[] = {MFHI, MFLO};
 const char *NO_OPERAND_INSTR[] = {RET};
 const char *MEM_DISPLAY_INSTR[] = {MEM};
-const char *MOV_INSTR[] = {MOV, MOVI};
+const char *MOV_INSTR[] = {MOV, MOVI, LUI, CMOVE, CMOVNE, CMOVS, CMOVNS, CMOVG,
+    CMOVGE, CMOVL, CMOVLE};
+const char *BLOCK_INSTR[] = {MEMCPY, MEMSET};
+const char *PACKED_INSTR[] = {PADDB, PADDH, PSUBB, PSUBH, PADDUSB, PADDUSH, PSUBUSB,
+    PSUBUSH, PCMPEQB, PCMPEQH, PCMPGTB, PCMPGTH, PSHUFB};
+const char *CMOV_INSTR[] = {CMOVE, CMOVNE, CMOVS, CMOVNS, CMOVG, CMOVGE, CMOVL, CMOVLE};
+const char *FP_INSTR[] = {FADDS, FADDD, FSUBS, FSUBD, FMULS, FMULD, FDIVS, FDIVD, FSQRTS,
+    FSQRTD, FCMPS, FCMPD, FCVTSW, FCVTDW, FCVTWS, FCVTWD, FCVTSD, FCVTDS};
+const char *FP_MEM_INSTR[] = {FLOADS, FLOADD, FSTORES, FSTORED};
+// Conversions reading an integer register/writing an integer register
+const char *FP_FROM_INT_INSTR[] = {FCVTSW, FCVTDW};
+const char *FP_TO_INT_INSTR[] = {FCVTWS, FCVTWD};
 
 // Define the number of instructions in all categories
 const int NUM_VALID_R_INSTR = sizeof(R_INSTR)/sizeof(R_INSTR[0]);
@@ -176,9 +309,17 @@ const int NUM_VALID_I_INSTR = sizeof(I_INSTR)/sizeof(I_INSTR[0]);
 const int NUM_VALID_MEM_INSTR = sizeof(MEM_INSTR)/sizeof(MEM_INSTR[0]);
 const int NUM_VALID_CONTROL_INSTR = sizeof(CONTROL_INSTR)/sizeof(CONTROL_INSTR[0]);
 const int NUM_VALID_STACK_INSTR = sizeof(STACK_INSTR)/sizeof(STACK_INSTR[0]);
+const int NUM_VALID_HILO_INSTR = sizeof(HILO_INSTR)/sizeof(HILO_INSTR[0]);
 const int NUM_VALID_NO_OPERAND_INSTR = sizeof(NO_OPERAND_INSTR)/sizeof(NO_OPERAND_INSTR[0]);
 const int NUM_VALID_MEM_DISPLAY_INSTR = sizeof(MEM_DISPLAY_INSTR)/sizeof(MEM_DISPLAY_INSTR[0]);
 const int NUM_VALID_MOV_INSTR = sizeof(MOV_INSTR)/sizeof(MOV_INSTR[0]);
+const int NUM_VALID_BLOCK_INSTR = sizeof(BLOCK_INSTR)/sizeof(BLOCK_INSTR[0]);
+const int NUM_VALID_PACKED_INSTR = sizeof(PACKED_INSTR)/sizeof(PACKED_INSTR[0]);
+const int NUM_VALID_CMOV_INSTR = sizeof(CMOV_INSTR)/sizeof(CMOV_INSTR[0]);
+const int NUM_VALID_FP_INSTR = sizeof(FP_INSTR)/sizeof(FP_INSTR[0]);
+const int NUM_VALID_FP_MEM_INSTR = sizeof(FP_MEM_INSTR)/sizeof(FP_MEM_INSTR[0]);
+const int NUM_VALID_FP_FROM_INT_INSTR = sizeof(FP_FROM_INT_INSTR)/sizeof(FP_FROM_INT_INSTR[0]);
+const int NUM_VALID_FP_TO_INT_INSTR = sizeof(FP_TO_INT_INSTR)/sizeof(FP_TO_INT_INSTR[0]);
 
 // Define hex value to set/get condition flags
 // These values are used to set/get specific bits from FLAGS register
@@ -191,13 +332,47 @@ const int NUM_VALID_MOV_INSTR = sizeof(MOV_INSTR)/sizeof(MOV_INSTR[0]);
 // Enum to define various flags/condition codes
 typedef enum {SF, OF, PF, ZF, CF} status_flags;
 
+// Enum to define the conditions tested by conditional jumps/moves. The values
+// are also used as function field of the conditional move instructions.
+typedef enum {COND_E, COND_NE, COND_S, COND_NS, COND_G, COND_GE, COND_L, COND_LE} condition_codes;
+
 
 // Define a struct for instructions and corresponding binary notation
 struct instr_opcode {
     char* instruction;
     int opcode;
+    int funct;      // Function field, only for opcodes shared by a group of instructions
+};
+
+// Opcodes shared by a group of instructions. The instruction within the group
+// is selected by the function field in bits 8-11 of the binary instruction, so
+// these instructions must use a format which leaves bits 8-11 unused. The
+// floating point load/store use the memory format and keep their function
+// field in the unused bits 0-3 instead.
+#define FUNCT_SHIFT 8
+#define FUNCT_SHIFT_MEM 0
+#define FUNCT_MASK  0x0f
+#define CMOV_OPCODE 0x19
+#define BLOCK_OPCODE 0x1A
+#define PACKED_OPCODE 0x1B
+#define BITS_OPCODE 0x1C
+#define BITSI_OPCODE 0x3F
+#define MULDIV_OPCODE 0x1E
+#define FP_OPCODE 0x1F
+#define FCVT_OPCODE 0x0E
+#define FMEM_OPCODE 0x0F
+
+struct funct_opcode {
+    int opcode;
+    int shift;      // Position of the function field
 };
 
+const struct funct_opcode FUNCT_OPCODES[] = {{CMOV_OPCODE, FUNCT_SHIFT},
+    {BLOCK_OPCODE, FUNCT_SHIFT}, {PACKED_OPCODE, FUNCT_SHIFT}, {BITS_OPCODE, FUNCT_SHIFT},
+    {BITSI_OPCODE, FUNCT_SHIFT}, {MULDIV_OPCODE, FUNCT_SHIFT}, {FP_OPCODE, FUNCT_SHIFT},
+    {FCVT_OPCODE, FUNCT_SHIFT}, {FMEM_OPCODE, FUNCT_SHIFT_MEM}};
+const int NUM_FUNCT_OPCODES = sizeof(FUNCT_OPCODES)/sizeof(FUNCT_OPCODES[0]);
+
 
 #define TOTAL_LABELS 100
 struct label_pos {
@@ -208,8 +383,50 @@ struct label_pos {
 int LABEL_COUNT = 0;
 struct label_pos LABELS[TOTAL_LABELS];
 
+// Define the debugger limits. Breakpoints are kept as one flag per instruction
+// slot and watchpoints mark the memory page they fall in, so that the
+// interpreter only pays for them when at least one is set.
+#define TOTAL_INSTRUCTION_SLOTS ((INSTRUCTION_MEMORY_MAX - INSTRUCTION_MEMORY_MIN + 1) / INSTR_SIZE)
+#define TOTAL_WATCHPOINTS   16
+#define WATCH_PAGE_SHIFT    8       // 256 bytes per watched page
+#define TOTAL_WATCH_PAGES   (MEMORY_SIZE >> WATCH_PAGE_SHIFT)
+
+bool BREAKPOINTS[TOTAL_INSTRUCTION_SLOTS];
+int BREAKPOINT_COUNT = 0;
+
+SIZE_TYPE WATCHPOINTS[TOTAL_WATCHPOINTS];
+int WATCHPOINT_COUNT = 0;
+unsigned char WATCHED_PAGES[TOTAL_WATCH_PAGES];
+
+// Jumps/calls to labels which are not defined yet, patched by the assembler
+// once the label is reached. At most one per instruction slot.
+struct label_fixup {
+    char label[50];
+    int position;
+};
+
+int FIXUP_COUNT = 0;
+struct label_fixup FIXUPS[TOTAL_INSTRUCTION_SLOTS];
+
+// Set once every label of the program is stored, so that a jump to an unknown
+// label is an error rather than a forward reference.
+bool ALL_LABELS_KNOWN = false;
+
+// Largest number of threads the parallel assembler can use.
+#define MAX_ASSEMBLY_THREADS    64
+
+// Set whenever a breakpoint/watchpoint exists or the debugger is single stepping.
+bool DEBUGGER_ACTIVE = false;
+
+// Interpreter variants, each compiled with only the features it needs. The
+// traced variant prints every instruction and supports the debugger.
+typedef enum {INTERP_FAST, INTERP_CHECKED, INTERP_TRACED, INTERP_PROFILED} interpreter_variants;
+
+const char *interpreter_variant_names[] = {"fast", "checked", "traced", "profiled"};
+const int NUM_INTERPRETER_VARIANTS = sizeof(interpreter_variant_names)/sizeof(interpreter_variant_names[0]);
+
 // Define the opcodes for all instructions
-#define TOTAL_ASSEMBLY_OPCODES  46
+#define TOTAL_ASSEMBLY_OPCODES  112
 
 // Create an array of structs for all instructions and binary opcode mapping
 struct instr_opcode opcode_map[TOTAL_ASSEMBLY_OPCODES] = {
@@ -219,6 +436,15 @@ struct instr_opcode opcode_map[TOTAL_ASSEMBLY_OPCODES] = {
     {MOV, 0x03},
     {MOVI, 0x04},
     {LEA, 0x05},
+    {LUI, 0x06},
+    {MEMCPY, BLOCK_OPCODE, 0x00},
+    {MEMSET, BLOCK_OPCODE, 0x01},
+    {VLOAD, 0x07},
+    {VSTORE, 0x0C},
+    {FLOADS, FMEM_OPCODE, 0x00},
+    {FLOADD, FMEM_OPCODE, 0x01},
+    {FSTORES, FMEM_OPCODE, 0x02},
+    {FSTORED, FMEM_OPCODE, 0x03},
 
     {ADD, 0x20},
     {SUB, 0x21},
@@ -235,6 +461,54 @@ struct instr_opcode opcode_map[TOTAL_ASSEMBLY_OPCODES] = {
     {SRA, 0x2C},
     {SLTU, 0x2D},
 
+    {PADDB, PACKED_OPCODE, 0x00},
+    {PADDH, PACKED_OPCODE, 0x01},
+    {PSUBB, PACKED_OPCODE, 0x02},
+    {PSUBH, PACKED_OPCODE, 0x03},
+    {PADDUSB, PACKED_OPCODE, 0x04},
+    {PADDUSH, PACKED_OPCODE, 0x05},
+    {PSUBUSB, PACKED_OPCODE, 0x06},
+    {PSUBUSH, PACKED_OPCODE, 0x07},
+    {PCMPEQB, PACKED_OPCODE, 0x08},
+    {PCMPEQH, PACKED_OPCODE, 0x09},
+    {PCMPGTB, PACKED_OPCODE, 0x0A},
+    {PCMPGTH, PACKED_OPCODE, 0x0B},
+    {PSHUFB, PACKED_OPCODE, 0x0C},
+
+    {POPCNT, BITS_OPCODE, 0x00},
+    {CLZ, BITS_OPCODE, 0x01},
+    {CTZ, BITS_OPCODE, 0x02},
+    {BSWAP, BITS_OPCODE, 0x03},
+    {ROL, BITS_OPCODE, 0x04},
+    {ROR, BITS_OPCODE, 0x05},
+
+    {MULT, MULDIV_OPCODE, 0x00},
+    {MULTU, MULDIV_OPCODE, 0x01},
+    {DIVU, MULDIV_OPCODE, 0x02},
+    {MFHI, MULDIV_OPCODE, 0x03},
+    {MFLO, MULDIV_OPCODE, 0x04},
+    {CMP, 0x2E},
+    {TEST, 0x2F},
+
+    {FADDS, FP_OPCODE, 0x00},
+    {FADDD, FP_OPCODE, 0x01},
+    {FSUBS, FP_OPCODE, 0x02},
+    {FSUBD, FP_OPCODE, 0x03},
+    {FMULS, FP_OPCODE, 0x04},
+    {FMULD, FP_OPCODE, 0x05},
+    {FDIVS, FP_OPCODE, 0x06},
+    {FDIVD, FP_OPCODE, 0x07},
+    {FSQRTS, FP_OPCODE, 0x08},
+    {FSQRTD, FP_OPCODE, 0x09},
+    {FCMPS, FP_OPCODE, 0x0A},
+    {FCMPD, FP_OPCODE, 0x0B},
+    {FCVTSW, FCVT_OPCODE, 0x00},
+    {FCVTDW, FCVT_OPCODE, 0x01},
+    {FCVTWS, FCVT_OPCODE, 0x02},
+    {FCVTWD, FCVT_OPCODE, 0x03},
+    {FCVTSD, FCVT_OPCODE, 0x04},
+    {FCVTDS, FCVT_OPCODE, 0x05},
+
     {ADDI, 0x30},
     {SUBI, 0x31},
     {MULI, 0x32},
@@ -248,6 +522,10 @@ struct instr_opcode opcode_map[TOTAL_ASSEMBLY_OPCODES] = {
     {SLTI, 0x3A},
     {SRLI, 0x3B},
     {SRAI, 0x3C},
+    {CMPI, 0x3D},
+    {TESTI, 0x3E},
+    {ROLI, BITSI_OPCODE, 0x00},
+    {RORI, BITSI_OPCODE, 0x01},
 
     {JMP, 0x10},
     {JE, 0x11},
@@ -258,6 +536,16 @@ struct instr_opcode opcode_map[TOTAL_ASSEMBLY_OPCODES] = {
     {JGE, 0x16},
     {JL, 0x17},
     {JLE, 0x18},
+    {LOOP, 0x0D},
+
+    {CMOVE, CMOV_OPCODE, COND_E},
+    {CMOVNE, CMOV_OPCODE, COND_NE},
+    {CMOVS, CMOV_OPCODE, COND_S},
+    {CMOVNS, CMOV_OPCODE, COND_NS},
+    {CMOVG, CMOV_OPCODE, COND_G},
+    {CMOVGE, CMOV_OPCODE, COND_GE},
+    {CMOVL, CMOV_OPCODE, COND_L},
+    {CMOVLE, CMOV_OPCODE, COND_LE},
 
     {RET, 0x08},
     {CALL, 0x09},
@@ -269,7 +557,7 @@ struct instr_opcode opcode_map[TOTAL_ASSEMBLY_OPCODES] = {
 // Define constants for differentiating between various instructions opcode
 // formats
 typedef enum {LOAD_STORE, REG_REG, REG_MEM, MEM_REG, IMM_REG, IMM_MEM, MEM_DISPLAY, \
-    CONTROL_LABEL, STACK_REG, NO_OPERAND, MOV_REG_REG, MOV_IMM_REG} opcode_formats;
+    CONTROL_LABEL, STACK_REG, NO_OPERAND, MOV_REG_REG, MOV_IMM_REG, BLOCK_REG, HILO_REG, FP_REG_REG} opcode_formats;
 
 // Struct to store different attributes of an instruction
 struct instruction_attr {
@@ -280,7 +568,8 @@ struct instruction_attr {
     int offset;                 // Offset/displacement for generic memory address
     int scale;                  // Scale factor for generic memory address
     int operand_register;       // Operand register
-    int const_or_label;         // Immediate constant or label offset for control transfer/mov
+    SIGNED_SIZE_TYPE const_or_label;    // Immediate constant or label offset for control transfer/mov
+    bool is_extended;           // Immediate constant is held in the following extension word
 };
 
 #define REG_REG_IND 0x01
@@ -290,4 +579,9 @@ struct instruction_attr {
 #define MOV_REG_REG_IND 0x00
 #define MOV_IMM_REG_IND 0x01
 
+// Indicator for IMM_REG/MOV_IMM_REG instructions whose register wide immediate
+// constant is stored in an extension word right after the instruction.
+#define IMM_EXT_IND     0x01
+#define IMM_EXT_SHIFT   17
+
 #endif
@@ -0,0 +1,250 @@
+/*
+ * cpu_debugger.c: Breakpoints, memory watchpoints and the interactive debugger
+ * prompt for the CPU simulator.
+ *
+ * Breakpoints are stored as one flag per instruction slot and are consulted
+ * only from the decode and execute loop. Watchpoints mark the memory page they
+ * fall in, and only writes to a marked page are compared against the watch
+ * list. Both paths are guarded by DEBUGGER_ACTIVE, so the interpreter runs
+ * unchanged when nothing is set.
+ */
+
+void displayRegisters();
+void displayMemoryInRange(SIZE_TYPE start_index, SIZE_TYPE end_index);
+SIZE_TYPE readFromMemory(SIZE_TYPE start_index, int num_bytes);
+
+// Single stepping requested from the debugger prompt.
+bool debugger_step = false;
+
+// Set by a watched memory write, handled once the instruction completes.
+bool watchpoint_hit = false;
+SIZE_TYPE watchpoint_hit_address = 0;
+
+/*
+ * Recompute whether the execution loop has to consult the debugger at all.
+ */
+void
+updateDebuggerActive() {
+    DEBUGGER_ACTIVE = (BREAKPOINT_COUNT != 0 || WATCHPOINT_COUNT != 0 || debugger_step);
+}
+
+/*
+ * Function to resolve a breakpoint location into an instruction address. The
+ * location can either be a label or a base 10/hex instruction memory address.
+ *
+ * Returns -1 if the location is not a valid instruction address.
+ */
+long
+getBreakpointAddress(char *location) {
+    int label_index = getLabelIndex(location);
+    if (label_index != -1) {
+        return INSTRUCTION_MEMORY_MIN + LABELS[label_index].position * INSTR_SIZE;
+    }
+
+    long address = getLongFromBaseTenOrHexString(location);
+    if (address < INSTRUCTION_MEMORY_MIN || address > INSTRUCTION_MEMORY_MAX
+            || (address - INSTRUCTION_MEMORY_MIN) % INSTR_SIZE != 0) {
+        return -1;
+    }
+    return address;
+}
+
+/*
+ * Function to set or clear a breakpoint at the given label/address.
+ *
+ * Returns false if the location could not be resolved.
+ */
+bool
+setBreakpoint(char *location, bool enable) {
+    long address = getBreakpointAddress(location);
+    if (address == -1) {
+        printf("ERROR: Invalid breakpoint location '%s'. Expected a label or an instruction address.\n", location);
+        return false;
+    }
+
+    // A label at the end of a full instruction memory has no slot.
+    int slot = (address - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    if (slot < 0 || slot >= TOTAL_INSTRUCTION_SLOTS) {
+        printf("ERROR: Invalid breakpoint location '%s'. It falls outside instruction memory.\n", location);
+        return false;
+    }
+    if (BREAKPOINTS[slot] != enable) {
+        BREAKPOINTS[slot] = enable;
+        BREAKPOINT_COUNT += enable ? 1 : -1;
+    }
+    updateDebuggerActive();
+    return true;
+}
+
+/*
+ * Function to add a watchpoint on the word starting at the given data address.
+ *
+ * Returns false if the address is invalid or no more watchpoints can be set.
+ */
+bool
+setWatchpoint(char *location) {
+    long address = getLongFromBaseTenOrHexString(location);
+    if (address < 0 || address >= MEMORY_SIZE) {
+        printf("ERROR: Invalid watchpoint address '%s'.\n", location);
+        return false;
+    }
+    if (WATCHPOINT_COUNT >= TOTAL_WATCHPOINTS) {
+        printf("ERROR: Cannot set more than %d watchpoints.\n", TOTAL_WATCHPOINTS);
+        return false;
+    }
+
+    // A word can straddle two pages, mark both of them.
+    WATCHPOINTS[WATCHPOINT_COUNT++] = address;
+    WATCHED_PAGES[address >> WATCH_PAGE_SHIFT]++;
+    if (address + NUM_BYTES_IN_WORD - 1 < MEMORY_SIZE) {
+        WATCHED_PAGES[(address + NUM_BYTES_IN_WORD - 1) >> WATCH_PAGE_SHIFT]++;
+    }
+    updateDebuggerActive();
+    return true;
+}
+
+/*
+ * Function to compare a write against the watch list. It must only be called
+ * for writes that touch a watched page.
+ */
+void
+checkWatchpoints(SIZE_TYPE start_index, int num_bytes) {
+    int i;
+    for (i = 0; i < WATCHPOINT_COUNT; i++) {
+        SIZE_TYPE watched = WATCHPOINTS[i];
+        if (start_index < watched + NUM_BYTES_IN_WORD && watched < start_index + num_bytes) {
+            watchpoint_hit = true;
+            watchpoint_hit_address = watched;
+            return;
+        }
+    }
+}
+
+/*
+ * Returns true if the write of num_bytes at start_index touches a watched
+ * page. Callers check DEBUGGER_ACTIVE first.
+ */
+static inline bool
+isWatchedPageWrite(SIZE_TYPE start_index, int num_bytes) {
+    SIZE_TYPE end_index = start_index + num_bytes - 1;
+    SIZE_TYPE page;
+    if (end_index >= MEMORY_SIZE) {
+        end_index = MEMORY_SIZE - 1;
+    }
+    // Block writes can span many pages.
+    for (page = start_index >> WATCH_PAGE_SHIFT; page <= end_index >> WATCH_PAGE_SHIFT; page++) {
+        if (WATCHED_PAGES[page] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Function to be called for every memory write that does not go through
+ * writeIntoMemory, e.g. R-type/I-type memory operands.
+ */
+static inline void
+notifyMemoryWrite(SIZE_TYPE start_index, int num_bytes) {
+    if (DEBUGGER_ACTIVE && isWatchedPageWrite(start_index, num_bytes)) {
+        checkWatchpoints(start_index, num_bytes);
+    }
+}
+
+/*
+ * Returns true if execution should stop before the instruction at instr_addr.
+ */
+static inline bool
+isBreakpointHit(SIZE_TYPE instr_addr) {
+    if (debugger_step) {
+        return true;
+    }
+    SIZE_TYPE slot = (instr_addr - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    return slot < TOTAL_INSTRUCTION_SLOTS && BREAKPOINTS[slot];
+}
+
+/*
+ * Function to display the debugger commands.
+ */
+void
+displayDebuggerHelp() {
+    printf("Debugger commands:\n");
+    printf("  c                 Continue execution\n");
+    printf("  s                 Execute a single instruction\n");
+    printf("  r                 Display registers\n");
+    printf("  m <start> <end>   Display memory in range\n");
+    printf("  b <label|addr>    Set breakpoint\n");
+    printf("  d <label|addr>    Delete breakpoint\n");
+    printf("  w <addr>          Set watchpoint on the word at addr\n");
+    printf("  q                 Quit the simulator\n");
+}
+
+/*
+ * Function to run the interactive debugger prompt. The prompt reads commands
+ * from stdin till execution is resumed. End of input resumes execution with
+ * the debugger disabled.
+ */
+void
+runDebuggerPrompt(SIZE_TYPE instr_addr) {
+    char line[100];
+    char command[10];
+    char arg1[50];
+    char arg2[50];
+
+    if (watchpoint_hit) {
+        printf("\nWatchpoint hit: write to 0x%" PRIxW ", new value 0x%" PRIxW "\n",
+                watchpoint_hit_address, readFromMemory(watchpoint_hit_address, NUM_BYTES_IN_WORD));
+        watchpoint_hit = false;
+    } else {
+        printf("\nBreakpoint hit at instruction address 0x%" PRIxW " (%" PRIuW ")\n", instr_addr, instr_addr);
+    }
+    debugger_step = false;
+
+    while (true) {
+        printf("(dbg) ");
+        fflush(stdout);
+        if (fgets(line, sizeof(line), stdin) == NULL) {
+            // No more commands, run till completion without stopping.
+            memset(BREAKPOINTS, 0, sizeof(BREAKPOINTS));
+            memset(WATCHED_PAGES, 0, sizeof(WATCHED_PAGES));
+            BREAKPOINT_COUNT = 0;
+            WATCHPOINT_COUNT = 0;
+            updateDebuggerActive();
+            printf("\n");
+            return;
+        }
+
+        int count = sscanf(line, "%9s %49s %49s", command, arg1, arg2);
+        if (count < 1) {
+            continue;
+        }
+
+        if (strcmp(command, "c") == 0) {
+            break;
+        } else if (strcmp(command, "s") == 0) {
+            debugger_step = true;
+            break;
+        } else if (strcmp(command, "r") == 0) {
+            displayRegisters();
+        } else if (strcmp(command, "m") == 0 && count == 3) {
+            long start = getLongFromBaseTenOrHexString(arg1);
+            long end = getLongFromBaseTenOrHexString(arg2);
+            if (start < NUM_BYTES_IN_WORD || end < start || end + NUM_BYTES_IN_WORD > MEMORY_SIZE) {
+                printf("ERROR: Invalid address range passed.\n");
+                continue;
+            }
+            displayMemoryInRange(start, end);
+        } else if (strcmp(command, "b") == 0 && count == 2) {
+            setBreakpoint(arg1, true);
+        } else if (strcmp(command, "d") == 0 && count == 2) {
+            setBreakpoint(arg1, false);
+        } else if (strcmp(command, "w") == 0 && count == 2) {
+            setWatchpoint(arg1);
+        } else if (strcmp(command, "q") == 0) {
+            exit(0);
+        } else {
+            displayDebuggerHelp();
+        }
+    }
+    updateDebuggerActive();
+}
@@ -0,0 +1,112 @@
+/*
+ * cpu_fpu.c: Floating point unit of the CPU simulator.
+ *
+ * The floating point registers hold IEEE-754 double precision values and all
+ * arithmetic is done by the host FPU. Single precision instructions round their
+ * operands and result to float, so a single precision value is always exactly
+ * representable in its register. FCMP reports the comparison through the
+ * integer FLAGS register, so the existing conditional jumps/moves can be used
+ * after it.
+ */
+
+typedef enum {FP_ADD, FP_SUB, FP_MUL, FP_DIV, FP_SQRT} fp_operations;
+
+/*
+ * Round a register value to single precision.
+ */
+static inline double
+roundToSingle(double val) {
+    return (double) (float) val;
+}
+
+/*
+ * Function to compute val2 op val1 (or op val1 for square root) in single or
+ * double precision.
+ */
+double
+floatOperation(fp_operations operation, double val1, double val2, bool is_single) {
+    if (is_single) {
+        float a = (float) val2;
+        float b = (float) val1;
+        switch (operation) {
+            case FP_ADD:  return a + b;
+            case FP_SUB:  return a - b;
+            case FP_MUL:  return a * b;
+            case FP_DIV:  return a / b;
+            default:      return sqrtf(b);
+        }
+    }
+
+    switch (operation) {
+        case FP_ADD:  return val2 + val1;
+        case FP_SUB:  return val2 - val1;
+        case FP_MUL:  return val2 * val1;
+        case FP_DIV:  return val2 / val1;
+        default:      return sqrt(val1);
+    }
+}
+
+/*
+ * Function to set the FLAGS register for the comparison of val2 with val1, the
+ * same order as CMP. The flags are set as a signed integer compare would set
+ * them, so JE/JNE/JG/JGE/JL/JLE work as expected:
+ *  val2 == val1: ZF = 1
+ *  val2 < val1:  SF = 1, CF = 1
+ *  val2 > val1:  all flags clear
+ *  unordered (either value is NaN): ZF = 1, PF = 1, CF = 1
+ */
+void
+setFlagsFromFloatCompare(double val1, double val2) {
+    FLAGS = FLAGS & ~(HEX_SF | HEX_OF | HEX_PF | HEX_ZF | HEX_CF);
+    if (isunordered(val2, val1)) {
+        FLAGS = FLAGS | HEX_ZF | HEX_PF | HEX_CF;
+    } else if (val2 == val1) {
+        FLAGS = FLAGS | HEX_ZF;
+    } else if (val2 < val1) {
+        FLAGS = FLAGS | HEX_SF | HEX_CF;
+    }
+}
+
+/*
+ * Function to convert a floating point value to a signed integer, rounding
+ * towards zero. NaN and out of range values give the most negative integer,
+ * like the x86 cvttsd2si instruction.
+ */
+SIZE_TYPE
+floatToInteger(double val) {
+    double limit = ldexp(1.0, WORD_SIZE - 1);
+    if (isnan(val) || val >= limit || val < -limit) {
+        return (SIZE_TYPE) 1 << (WORD_SIZE - 1);
+    }
+    return (SIZE_TYPE) (SIGNED_SIZE_TYPE) val;
+}
+
+/*
+ * Function to read a single (4 bytes) or double (8 bytes) precision value from
+ * memory. The address must already be validated.
+ */
+double
+readFloatFromMemory(SIZE_TYPE memory_address, bool is_single) {
+    if (is_single) {
+        float val;
+        memcpy(&val, &MEMORY[memory_address], sizeof(val));
+        return val;
+    }
+    double val;
+    memcpy(&val, &MEMORY[memory_address], sizeof(val));
+    return val;
+}
+
+/*
+ * Function to write a single (4 bytes) or double (8 bytes) precision value into
+ * memory. The address must already be validated.
+ */
+void
+writeFloatIntoMemory(SIZE_TYPE memory_address, double val, bool is_single) {
+    if (is_single) {
+        float single = (float) val;
+        writeIntoMemory(memory_address, sizeof(single), (data_ptr) &single);
+    } else {
+        writeIntoMemory(memory_address, sizeof(val), (data_ptr) &val);
+    }
+}
@@ -0,0 +1,436 @@
+/*
+ * cpu_hotloop.c: Hot-loop traces for the fast interpreter.
+ *
+ * The fast interpreter counts the taken backward jumps to each loop head. Once
+ * a loop head reaches HOT_LOOP_THRESHOLD, the next iteration of the loop is
+ * recorded as it executes, into a linear trace of pre-decoded operations. Each
+ * operation is bound to its handler and its register/constant operands, so
+ * running the trace skips the fetch, decode and string compare dispatch of the
+ * interpreter.
+ *
+ * The conditional jumps and loop instructions of the recorded iteration become
+ * guards that expect the direction taken while recording, and a ret becomes a
+ * guard that expects the return address it popped while recording. The trace
+ * repeats until a guard fails, and execution goes back to the interpreter at
+ * the PC the failed guard continues at.
+ *
+ * Recording is abandoned for loops that contain an inner loop, and such loops
+ * are left to the interpreter. The inner loop gets a trace of its own.
+ */
+
+#define HOT_LOOP_THRESHOLD      50
+#define MAX_HOT_TRACES          32
+#define MAX_TRACE_LENGTH        128
+#define MAX_TRACE_ATTEMPTS      4
+
+struct trace_op;
+typedef bool (*trace_handler)(struct trace_op *op);
+
+// One pre-decoded instruction of a trace. The handler returns false when the
+// operation is a guard that failed, after setting the PC to where the
+// interpreter continues.
+struct trace_op {
+    trace_handler execute;
+    void (*reg_reg)(SIZE_TYPE*, SIZE_TYPE*);
+    void (*imm_reg)(SIZE_TYPE, SIZE_TYPE*);
+    SIZE_TYPE *arg1;
+    SIZE_TYPE *arg2;
+    SIZE_TYPE constant;
+    condition_codes condition;
+    bool taken;                 // Direction of the guard while recording
+    bool flags_dead;            // Flags update skipped by the flag liveness
+    SIZE_TYPE exit_pc;          // Where a failed jump guard continues
+    SIZE_TYPE return_address;   // Pushed by a call, or expected by a ret
+    struct instruction_attr instr_attr;
+};
+
+struct hot_trace {
+    SIZE_TYPE head_pc;
+    int length;
+    struct trace_op ops[MAX_TRACE_LENGTH];
+};
+
+struct hot_trace HOT_TRACES[MAX_HOT_TRACES];
+int HOT_TRACE_COUNT = 0;
+
+// Taken backward jumps to each instruction memory word.
+unsigned int HOT_LOOP_COUNTS[TOTAL_INSTRUCTION_SLOTS];
+
+// Failed recordings of the loop headed by each instruction memory word.
+unsigned char HOT_TRACE_ATTEMPTS[TOTAL_INSTRUCTION_SLOTS];
+
+// Trace of the loop headed by each instruction memory word, as index + 1. A
+// loop that could not be recorded is marked with -1.
+int HOT_TRACE_AT_SLOT[TOTAL_INSTRUCTION_SLOTS];
+
+// Trace being recorded, if any.
+struct hot_trace *RECORDING_TRACE = NULL;
+
+int HOT_TRACE_ABORTS = 0;
+long HOT_TRACE_INSTRUCTIONS = 0;
+
+struct trace_reg_reg_entry {
+    const char *instruction;
+    void (*execute)(SIZE_TYPE*, SIZE_TYPE*);
+};
+
+struct trace_imm_reg_entry {
+    const char *instruction;
+    void (*execute)(SIZE_TYPE, SIZE_TYPE*);
+};
+
+struct trace_jump_entry {
+    const char *instruction;
+    condition_codes condition;
+};
+
+// R-Type instructions with the handler that executeRTypeInstructions calls.
+const struct trace_reg_reg_entry TRACE_REG_REG_HANDLERS[] = {
+    {ADD, executeAdd}, {SUB, executeSub}, {MUL, executeMul}, {DIV, executeDiv},
+    {MOD, executeMod}, {AND, executeAND}, {OR, executeOR}, {XOR, executeXOR},
+    {NOT, executeNOT}, {NOR, executeNOR}, {SLT, executeSLT}, {SLL, executeSLL},
+    {SRL, executeSRL}, {SRA, executeSRA}, {CMP, executeCmp}, {MULT, executeMult},
+    {MULTU, executeMultU}, {DIVU, executeDivU}, {POPCNT, executePopcnt}, {CLZ, executeClz},
+    {CTZ, executeCtz}, {BSWAP, executeBswap}, {ROL, executeRol}, {ROR, executeRor},
+    {TEST, executeTest}
+};
+
+// Immediate-Type instructions with the handler that executeITypeInstructions calls.
+const struct trace_imm_reg_entry TRACE_IMM_REG_HANDLERS[] = {
+    {ADDI, executeAddI}, {SUBI, executeSubI}, {MULI, executeMulI}, {DIVI, executeDivI},
+    {MODI, executeModI}, {ANDI, executeANDI}, {ORI, executeORI}, {XORI, executeXORI},
+    {NORI, executeNORI}, {SLTI, executeSLTI}, {SLLI, executeSLLI}, {SRLI, executeSRLI},
+    {SRAI, executeSRAI}, {ROLI, executeRolI}, {RORI, executeRorI}, {CMPI, executeCmpI},
+    {TESTI, executeTestI}
+};
+
+const struct trace_jump_entry TRACE_JUMP_CONDITIONS[] = {
+    {JE, COND_E}, {JNE, COND_NE}, {JS, COND_S}, {JNS, COND_NS},
+    {JG, COND_G}, {JGE, COND_GE}, {JL, COND_L}, {JLE, COND_LE}
+};
+
+#define NUM_TRACE_REG_REG_HANDLERS  (sizeof(TRACE_REG_REG_HANDLERS)/sizeof(TRACE_REG_REG_HANDLERS[0]))
+#define NUM_TRACE_IMM_REG_HANDLERS  (sizeof(TRACE_IMM_REG_HANDLERS)/sizeof(TRACE_IMM_REG_HANDLERS[0]))
+#define NUM_TRACE_JUMP_CONDITIONS   (sizeof(TRACE_JUMP_CONDITIONS)/sizeof(TRACE_JUMP_CONDITIONS[0]))
+
+/*
+ * Trace handler of register to register operations.
+ */
+bool
+traceRegReg(struct trace_op *op) {
+    op->reg_reg(op->arg1, op->arg2);
+    return true;
+}
+
+/*
+ * Trace handler of immediate to register operations.
+ */
+bool
+traceImmReg(struct trace_op *op) {
+    op->imm_reg(op->constant, op->arg2);
+    return true;
+}
+
+/*
+ * Trace handler of register to memory operations. The word is stored back
+ * unchanged by cmp/test.
+ */
+bool
+traceRegMem(struct trace_op *op) {
+    SIZE_TYPE memory_address = computeMemoryOperandAddress(&op->instr_attr);
+    SIZE_TYPE memory_operand = loadMemoryWord(memory_address);
+    op->reg_reg(op->arg1, &memory_operand);
+    storeMemoryWord(memory_address, memory_operand);
+    return true;
+}
+
+/*
+ * Trace handler of memory to register operations.
+ */
+bool
+traceMemReg(struct trace_op *op) {
+    SIZE_TYPE memory_operand = loadMemoryWord(computeMemoryOperandAddress(&op->instr_attr));
+    op->reg_reg(&memory_operand, op->arg2);
+    return true;
+}
+
+/*
+ * Trace handler of immediate to memory operations. The word is stored back
+ * unchanged by cmpi/testi.
+ */
+bool
+traceImmMem(struct trace_op *op) {
+    SIZE_TYPE memory_address = computeMemoryOperandAddress(&op->instr_attr);
+    SIZE_TYPE memory_operand = loadMemoryWord(memory_address);
+    op->imm_reg(op->constant, &memory_operand);
+    storeMemoryWord(memory_address, memory_operand);
+    return true;
+}
+
+/*
+ * Trace handler of the instructions without a bound handler, which are
+ * executed from their decoded attributes as the interpreter does.
+ */
+bool
+traceGeneric(struct trace_op *op) {
+    executeInstruction(&op->instr_attr);
+    return true;
+}
+
+/*
+ * Trace handler of jmp, which the trace has already followed.
+ */
+bool
+traceJump(struct trace_op *op) {
+    return true;
+}
+
+/*
+ * Guard of a conditional jump. Fails if the jump goes the other way than it
+ * did while recording.
+ */
+bool
+traceConditionGuard(struct trace_op *op) {
+    if (isConditionSatisfied(op->condition) == op->taken) {
+        return true;
+    }
+    PC = op->exit_pc;
+    return false;
+}
+
+/*
+ * Guard of a loop instruction. Decrements the counter register as
+ * executeLoop does, and fails if the jump goes the other way than it did while
+ * recording.
+ */
+bool
+traceLoopGuard(struct trace_op *op) {
+    *op->arg2 = *op->arg2 - 1;
+    if ((*op->arg2 != 0) == op->taken) {
+        return true;
+    }
+    PC = op->exit_pc;
+    return false;
+}
+
+/*
+ * Trace handler of call, whose target the trace has already followed.
+ */
+bool
+traceCall(struct trace_op *op) {
+    pushReturnAddress(op->return_address);
+    return true;
+}
+
+/*
+ * Guard of a ret. Fails if it returns elsewhere than it did while recording.
+ */
+bool
+traceReturnGuard(struct trace_op *op) {
+    PC = popReturnAddress();
+    return PC == op->return_address;
+}
+
+/*
+ * Function to bind the decoded instruction to its trace handler and operands.
+ * next_pc is the address after the instruction, and PC is the address
+ * execution went on at.
+ */
+void
+bindTraceOp(struct trace_op *op, struct instruction_attr *instr_attr_ptr, SIZE_TYPE next_pc) {
+    char *command = instr_attr_ptr->instruction;
+    size_t i;
+
+    memset(op, 0, sizeof(*op));
+    op->instr_attr = *instr_attr_ptr;
+    op->flags_dead = skip_flags_update;
+    op->execute = traceGeneric;
+
+    switch (instr_attr_ptr->format) {
+        default:
+            break;
+        case NO_OPERAND:
+            if (strcmp(command, RET) == 0) {
+                op->execute = traceReturnGuard;
+                op->return_address = PC;
+            }
+            break;
+        case REG_REG:
+        case REG_MEM:
+        case MEM_REG:
+            for (i = 0; i < NUM_TRACE_REG_REG_HANDLERS; i++) {
+                if (strcmp(command, TRACE_REG_REG_HANDLERS[i].instruction) == 0) {
+                    op->reg_reg = TRACE_REG_REG_HANDLERS[i].execute;
+                    if (instr_attr_ptr->format == REG_REG) {
+                        op->execute = traceRegReg;
+                        op->arg1 = &GPRS[instr_attr_ptr->operand_register];
+                        op->arg2 = &GPRS[instr_attr_ptr->base_register];
+                    } else if (instr_attr_ptr->format == REG_MEM) {
+                        op->execute = traceRegMem;
+                        op->arg1 = &GPRS[instr_attr_ptr->operand_register];
+                    } else {
+                        op->execute = traceMemReg;
+                        op->arg2 = &GPRS[instr_attr_ptr->operand_register];
+                    }
+                }
+            }
+            break;
+        case IMM_REG:
+        case IMM_MEM:
+            for (i = 0; i < NUM_TRACE_IMM_REG_HANDLERS; i++) {
+                if (strcmp(command, TRACE_IMM_REG_HANDLERS[i].instruction) == 0) {
+                    op->execute = instr_attr_ptr->format == IMM_REG ? traceImmReg : traceImmMem;
+                    op->imm_reg = TRACE_IMM_REG_HANDLERS[i].execute;
+                    op->constant = instr_attr_ptr->const_or_label;
+                    op->arg2 = &GPRS[instr_attr_ptr->operand_register];
+                }
+            }
+            break;
+        case MOV_REG_REG:
+            if (strcmp(command, MOV) == 0) {
+                op->execute = traceRegReg;
+                op->reg_reg = executeMov;
+                op->arg1 = &GPRS[instr_attr_ptr->base_register];
+                op->arg2 = &GPRS[instr_attr_ptr->operand_register];
+            }
+            break;
+        case MOV_IMM_REG:
+            if (strcmp(command, MOVI) == 0 || strcmp(command, LUI) == 0) {
+                op->execute = traceImmReg;
+                op->imm_reg = strcmp(command, MOVI) == 0 ? executeMovI : executeLUI;
+                op->constant = instr_attr_ptr->const_or_label;
+                op->arg2 = &GPRS[instr_attr_ptr->operand_register];
+            }
+            break;
+        case CONTROL_LABEL:
+            if (strcmp(command, CALL) == 0) {
+                op->execute = traceCall;
+                op->return_address = next_pc;
+                break;
+            }
+            // The exit of a guard is the direction not taken while recording.
+            op->taken = PC != next_pc;
+            op->exit_pc = op->taken ? next_pc : next_pc + instr_attr_ptr->const_or_label * INSTR_SIZE;
+            if (strcmp(command, JMP) == 0) {
+                op->execute = traceJump;
+            } else if (strcmp(command, LOOP) == 0) {
+                op->execute = traceLoopGuard;
+                op->arg2 = &GPRS[instr_attr_ptr->operand_register];
+            } else {
+                op->execute = traceConditionGuard;
+                for (i = 0; i < NUM_TRACE_JUMP_CONDITIONS; i++) {
+                    if (strcmp(command, TRACE_JUMP_CONDITIONS[i].instruction) == 0) {
+                        op->condition = TRACE_JUMP_CONDITIONS[i].condition;
+                    }
+                }
+            }
+            break;
+    }
+}
+
+/*
+ * Function to give up recording the current trace, which is always the last
+ * one. The loop is recorded again from its next taken backward jump, as the
+ * recorded iteration may have been the one leaving the loop, until it has
+ * failed MAX_TRACE_ATTEMPTS times.
+ */
+void
+abortHotTrace() {
+    SIZE_TYPE slot = (RECORDING_TRACE->head_pc - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    if (++HOT_TRACE_ATTEMPTS[slot] == MAX_TRACE_ATTEMPTS) {
+        HOT_TRACE_AT_SLOT[slot] = -1;
+    }
+    RECORDING_TRACE = NULL;
+    HOT_TRACE_COUNT--;
+    HOT_TRACE_ABORTS++;
+}
+
+/*
+ * Function to append the instruction just executed by the interpreter, found
+ * at instr_pc, to the trace being recorded. The trace is complete when the
+ * instruction goes back to the loop head.
+ */
+void
+recordTraceInstruction(struct instruction_attr *instr_attr_ptr, SIZE_TYPE instr_pc) {
+    struct hot_trace *trace = RECORDING_TRACE;
+    SIZE_TYPE next_pc = instr_pc + INSTR_SIZE + (instr_attr_ptr->is_extended ? NUM_BYTES_IN_WORD : 0);
+
+    if (trace->length == MAX_TRACE_LENGTH) {
+        abortHotTrace();
+        return;
+    }
+    bindTraceOp(&trace->ops[trace->length++], instr_attr_ptr, next_pc);
+
+    if (PC == trace->head_pc) {
+        HOT_TRACE_AT_SLOT[(trace->head_pc - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE] = (trace - HOT_TRACES) + 1;
+        RECORDING_TRACE = NULL;
+    } else if (instr_attr_ptr->format == CONTROL_LABEL && strcmp(instr_attr_ptr->instruction, CALL) != 0
+            && PC <= instr_pc) {
+        // Inner loop, which is traced on its own.
+        abortHotTrace();
+    }
+}
+
+/*
+ * Function to run the trace until one of its guards fails, which leaves the
+ * PC at where the interpreter continues.
+ *
+ * Returns the number of executed instructions.
+ */
+long
+runHotTrace(struct hot_trace *trace) {
+    struct trace_op *end = &trace->ops[trace->length];
+    long executed = 0;
+    while (true) {
+        struct trace_op *op;
+        for (op = trace->ops; op < end; op++) {
+            skip_flags_update = op->flags_dead;
+            isSubtract = false;
+            if (!op->execute(op)) {
+                executed += (op - trace->ops) + 1;
+                HOT_TRACE_INSTRUCTIONS += executed;
+                return executed;
+            }
+        }
+        executed += trace->length;
+    }
+}
+
+/*
+ * Function called by the interpreter for every taken backward jump, with the
+ * PC at the loop head. Runs the trace of the loop if there is one, or starts
+ * recording it once the loop is hot.
+ *
+ * Returns the number of instructions executed from the trace.
+ */
+long
+enterHotLoop() {
+    SIZE_TYPE slot = (PC - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    if (slot >= TOTAL_INSTRUCTION_SLOTS || HOT_TRACE_AT_SLOT[slot] < 0) {
+        return 0;
+    }
+    if (HOT_TRACE_AT_SLOT[slot] > 0) {
+        return runHotTrace(&HOT_TRACES[HOT_TRACE_AT_SLOT[slot] - 1]);
+    }
+    if (++HOT_LOOP_COUNTS[slot] >= HOT_LOOP_THRESHOLD && HOT_TRACE_COUNT < MAX_HOT_TRACES) {
+        RECORDING_TRACE = &HOT_TRACES[HOT_TRACE_COUNT++];
+        RECORDING_TRACE->head_pc = PC;
+        RECORDING_TRACE->length = 0;
+    }
+    return 0;
+}
+
+/*
+ * Function to print the hot-loop trace counts as a line of key=value pairs on
+ * stderr.
+ */
+void
+displayHotLoopStats() {
+    int traces = 0;
+    int i;
+    for (i = 0; i < TOTAL_INSTRUCTION_SLOTS; i++) {
+        traces += HOT_TRACE_AT_SLOT[i] > 0;
+    }
+    fprintf(stderr, "hot_loop_traces=%d trace_aborts=%d trace_instructions=%ld\n",
+            traces, HOT_TRACE_ABORTS, HOT_TRACE_INSTRUCTIONS);
+}
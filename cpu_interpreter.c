@@ -0,0 +1,101 @@
+/*
+ * cpu_interpreter.c: Decode and execute loop of the CPU simulator. The file is
+ * included once per interpreter variant, and each inclusion generates one
+ * specialised loop. The following macros select the variant and are undefined
+ * at the end of the file so that it can be included again:
+ *
+ *  INTERP_NAME:    Name of the generated function.
+ *  INTERP_TRACE:   Print every instruction and the registers after it, and stop
+ *                  for breakpoints/watchpoints.
+ *  INTERP_CHECK:   Validate the PC and SP before every instruction.
+ *  INTERP_PROFILE: Count the executed instructions per opcode.
+ *  INTERP_HOT_LOOPS: Run hot loops from their recorded traces.
+ *
+ * Features that are not selected are compiled out, so the fast variant runs
+ * the bare decode and execute loop. All but the traced variant skip the flag
+ * updates found dead by the flag liveness analysis.
+ *
+ * Returns the number of executed instructions.
+ */
+
+long
+INTERP_NAME() {
+   SIZE_TYPE binary_opcode = readFromMemory(PC, INSTR_SIZE);
+   PC = PC + INSTR_SIZE;
+   long instr_count = 1;
+
+   while (binary_opcode != 0) {
+#if INTERP_TRACE
+       // Stop for breakpoints/single stepping before executing the instruction.
+       if (DEBUGGER_ACTIVE && isBreakpointHit(PC - INSTR_SIZE)) {
+           runDebuggerPrompt(PC - INSTR_SIZE);
+       }
+#endif
+
+       struct instruction_attr instr_attr;
+#if INTERP_HOT_LOOPS
+       SIZE_TYPE instr_pc = PC - INSTR_SIZE;
+#endif
+#if !INTERP_TRACE || INTERP_PROFILE
+       SIZE_TYPE instr_slot = (PC - INSTR_SIZE - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+#endif
+#if !INTERP_TRACE
+       // Skip the flags update of instructions whose flags are never read.
+       skip_flags_update = instr_slot < TOTAL_INSTRUCTION_SLOTS && FLAGS_DEAD[instr_slot];
+#endif
+#if INTERP_TRACE
+       printf("Instruction Count: %ld\t Executing opcode: 0x%" PRIxW, instr_count, binary_opcode);
+#endif
+       isSubtract = false;
+       decodeInstructionFromBinary(binary_opcode, &instr_attr);
+
+       // Fetch the wide immediate constant from the extension word.
+       if (instr_attr.is_extended) {
+           instr_attr.const_or_label = readFromMemory(PC, NUM_BYTES_IN_WORD);
+           PC = PC + NUM_BYTES_IN_WORD;
+       }
+
+#if INTERP_TRACE
+       printf("\t Assembly Instruction: %s\n", instr_attr.instruction);
+#endif
+#if INTERP_PROFILE
+       profileInstruction(binary_opcode, instr_slot);
+#endif
+
+       executeInstruction(&instr_attr);
+
+#if INTERP_TRACE
+       displayRegisters();
+
+       // Stop after the instruction that wrote to a watched address.
+       if (watchpoint_hit) {
+           runDebuggerPrompt(PC - INSTR_SIZE);
+       }
+       PRINT_CHAR('=', 85);NEWLINE(1);
+       PRINT_CHAR('=', 85); NEWLINE(2);
+#endif
+#if INTERP_CHECK
+       checkValidExecutionState();
+#endif
+#if INTERP_HOT_LOOPS
+       // Record the trace of a hot loop, or run it on a taken backward jump.
+       if (RECORDING_TRACE != NULL) {
+           recordTraceInstruction(&instr_attr, instr_pc);
+       }
+       if (RECORDING_TRACE == NULL && instr_attr.format == CONTROL_LABEL && PC <= instr_pc) {
+           instr_count += enterHotLoop();
+       }
+#endif
+       // Read the next instruction and increment the PC
+       binary_opcode = readFromMemory(PC, INSTR_SIZE);
+       PC = PC + INSTR_SIZE;
+       instr_count++;
+   }
+   return instr_count - 1;
+}
+
+#undef INTERP_NAME
+#undef INTERP_TRACE
+#undef INTERP_CHECK
+#undef INTERP_PROFILE
+#undef INTERP_HOT_LOOPS
@@ -0,0 +1,170 @@
+/*
+ * cpu_linker.c: Relocatable object files and the linker.
+ *
+ * An object file holds the instruction memory image of one assembled source
+ * file, the labels it defines and a relocation for every jump/call to a label
+ * it does not define. Every label defined in an object is exported. Label
+ * offsets are relative to the jump, so jumps within an object need no
+ * relocation and only the imported labels are patched at link time.
+ *
+ * The linker places the objects one after another in instruction memory, in
+ * command line order, with a zero word between them so that execution stops
+ * at the end of the first object instead of running into the next one.
+ * Execution starts at the first instruction of the first object.
+ */
+
+void storeLabelFixup(char* label, int position);
+void resolveLabelFixups(char* label, int label_position);
+int storeLabelInformation(char* label, int position);
+
+#define OBJECT_MAGIC            0x4a424f43  // "COBJ"
+#define OBJECT_FORMAT_VERSION   1
+
+// Followed by the code, the label_pos symbols and the label_fixup relocations.
+struct object_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t word_size;
+    uint32_t code_size;
+    uint32_t symbol_count;
+    uint32_t relocation_count;
+};
+
+/*
+ * Returns true if the buffer holds an object file rather than source text.
+ */
+bool
+isObjectFile(struct source_buffer *buffer) {
+    uint32_t magic;
+    if (buffer->size < sizeof(magic)) {
+        return false;
+    }
+    memcpy(&magic, buffer->data, sizeof(magic));
+    return magic == OBJECT_MAGIC;
+}
+
+/*
+ * Function to write the assembled program to an object file. The labels that
+ * are still waiting in FIXUPS are the imported labels.
+ */
+void
+writeObjectFile(const char *file_name) {
+    FILE *fp = fopen(file_name, "wb");
+    if (fp == NULL) {
+        printf("ERROR: Cannot create object file '%s'.\n", file_name);
+        exit(EXIT_FAILURE);
+    }
+    struct object_header header = {OBJECT_MAGIC, OBJECT_FORMAT_VERSION, WORD_SIZE,
+        INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN, LABEL_COUNT, FIXUP_COUNT};
+    bool written = fwrite(&header, sizeof(header), 1, fp) == 1
+        && fwrite(&MEMORY[INSTRUCTION_MEMORY_MIN], 1, header.code_size, fp) == header.code_size
+        && fwrite(LABELS, sizeof(LABELS[0]), LABEL_COUNT, fp) == (size_t) LABEL_COUNT
+        && fwrite(FIXUPS, sizeof(FIXUPS[0]), FIXUP_COUNT, fp) == (size_t) FIXUP_COUNT;
+    if (fclose(fp) != 0 || !written) {
+        printf("ERROR: Cannot write object file '%s'.\n", file_name);
+        unlink(file_name);
+        exit(EXIT_FAILURE);
+    }
+    printf("Wrote object file '%s': %u bytes of instructions, %d labels, %d relocations.\n",
+            file_name, header.code_size, LABEL_COUNT, FIXUP_COUNT);
+}
+
+/*
+ * Function to load one object file at the end of the linked program. Its
+ * labels are stored with their final positions and its relocations are added
+ * to FIXUPS.
+ */
+void
+loadObjectFile(const char *file_name, struct source_buffer *object) {
+    struct object_header header;
+    if (object->size < sizeof(header)) {
+        printf("ERROR: '%s' is not a valid object file.\n", file_name);
+        exit(0);
+    }
+    memcpy(&header, object->data, sizeof(header));
+
+    size_t expected_size = sizeof(header) + (size_t) header.code_size
+        + (size_t) header.symbol_count * sizeof(struct label_pos)
+        + (size_t) header.relocation_count * sizeof(struct label_fixup);
+    if (header.magic != OBJECT_MAGIC || header.version != OBJECT_FORMAT_VERSION
+            || header.code_size % INSTR_SIZE != 0 || object->size != expected_size) {
+        printf("ERROR: '%s' is not a valid object file.\n", file_name);
+        exit(0);
+    }
+    if (header.word_size != WORD_SIZE) {
+        printf("ERROR: '%s' was assembled for a %u-bit word size.\n", file_name, header.word_size);
+        exit(0);
+    }
+    if (INSTR_MEMORY_PTR + header.code_size > INSTRUCTION_MEMORY_MAX + 1) {
+        printf("ERROR: Linked program does not fit in instruction memory.\n");
+        exit(0);
+    }
+
+    // Positions in the object are relative to its first instruction word.
+    int base_position = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    int object_words = header.code_size / INSTR_SIZE;
+    const char *data = object->data + sizeof(header);
+    memcpy(&MEMORY[INSTR_MEMORY_PTR], data, header.code_size);
+    data += header.code_size;
+
+    uint32_t i;
+    for (i = 0; i < header.symbol_count; i++) {
+        struct label_pos symbol;
+        memcpy(&symbol, data, sizeof(symbol));
+        data += sizeof(symbol);
+        symbol.label[sizeof(symbol.label) - 1] = '\0';
+        if (symbol.position < 0 || symbol.position > object_words) {
+            printf("ERROR: '%s' is not a valid object file.\n", file_name);
+            exit(0);
+        }
+        if (storeLabelInformation(symbol.label, base_position + symbol.position) == -1) {
+            printf("ERROR: Label '%s' defined in more than one object file.\n", symbol.label);
+            exit(0);
+        }
+    }
+    for (i = 0; i < header.relocation_count; i++) {
+        struct label_fixup relocation;
+        memcpy(&relocation, data, sizeof(relocation));
+        data += sizeof(relocation);
+        relocation.label[sizeof(relocation.label) - 1] = '\0';
+        if (relocation.position < 0 || relocation.position >= object_words) {
+            printf("ERROR: '%s' is not a valid object file.\n", file_name);
+            exit(0);
+        }
+        storeLabelFixup(relocation.label, base_position + relocation.position);
+    }
+    INSTR_MEMORY_PTR = INSTR_MEMORY_PTR + header.code_size;
+}
+
+/*
+ * Function to link the given object files into instruction memory, and
+ * resolve the labels imported by each object against the others.
+ */
+void
+linkObjectFiles(char **file_names, int count) {
+    int i;
+    for (i = 0; i < count; i++) {
+        struct source_buffer object;
+        openSourceBuffer(file_names[i], &object);
+        if (!isObjectFile(&object)) {
+            printf("ERROR: '%s' is not an object file; only object files can be linked.\n", file_names[i]);
+            exit(0);
+        }
+        // Zero word ending the previous object.
+        if (i != 0) {
+            INSTR_MEMORY_PTR = INSTR_MEMORY_PTR + INSTR_SIZE;
+        }
+        loadObjectFile(file_names[i], &object);
+        closeSourceBuffer(&object);
+    }
+
+    for (i = 0; i < LABEL_COUNT; i++) {
+        resolveLabelFixups(LABELS[i].label, LABELS[i].position);
+    }
+    if (FIXUP_COUNT != 0) {
+        printf("ERROR: Undefined label '%s'; not defined in any object file.\n", FIXUPS[0].label);
+        exit(0);
+    }
+    printf("Linked %d object files: %d bytes of instructions, %d labels.\n", count,
+            (int) (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN), LABEL_COUNT);
+}
@@ -0,0 +1,125 @@
+/*
+ * cpu_liveness.c: Flag liveness analysis.
+ *
+ * Most ALU instructions set the flags only for the next ALU instruction to
+ * overwrite them before any conditional jump/move reads them. The analysis
+ * finds these instructions over the CFG, and the non-traced interpreters skip
+ * their setFlagsRegister call.
+ *
+ * The flags are live at every exit of the program, so the last flags written
+ * before execution stops are always materialised for the final register
+ * display.
+ */
+
+// Set for the instruction memory words whose instruction sets flags that are
+// never read.
+bool FLAGS_DEAD[TOTAL_INSTRUCTION_SLOTS];
+
+// Set by the interpreter for an instruction in FLAGS_DEAD.
+bool skip_flags_update = false;
+
+/*
+ * Returns true if the instruction reads the flags i.e. the conditional jumps
+ * and conditional moves.
+ */
+bool
+readsFlags(struct instruction_attr *instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    if (instr_attr_ptr->format == CONTROL_LABEL) {
+        return strcmp(command, JMP) != 0 && strcmp(command, CALL) != 0 && strcmp(command, LOOP) != 0;
+    }
+    return IsStringInStringArray(command, CMOV_INSTR, NUM_VALID_CMOV_INSTR);
+}
+
+/*
+ * Returns true if the instruction overwrites every flag without going through
+ * setFlagsRegister i.e. the floating point compares.
+ */
+bool
+killsFlags(struct instruction_attr *instr_attr_ptr) {
+    return strcmp(instr_attr_ptr->instruction, FCMPS) == 0
+        || strcmp(instr_attr_ptr->instruction, FCMPD) == 0;
+}
+
+/*
+ * Function to compute whether the flags are live on entry to the block, given
+ * whether they are live at its end. With mark set, the instructions of the
+ * block whose flags are dead are marked in FLAGS_DEAD.
+ */
+bool
+computeBlockFlagLiveness(struct basic_block *block, bool live_out, bool mark) {
+    bool live = live_out;
+    int i;
+    for (i = block->end_instruction - 1; i >= block->first_instruction; i--) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        if (instr->binary_opcode == 0) {
+            live = true;
+            continue;
+        }
+        struct instruction_attr *attr = &instr->instr_attr;
+        if (writesAllFlags(attr)) {
+            if (mark) {
+                FLAGS_DEAD[instr->position] = !live;
+            }
+            live = false;
+        } else if (killsFlags(attr)) {
+            live = false;
+        }
+        if (readsFlags(attr)) {
+            live = true;
+        }
+    }
+    return live;
+}
+
+/*
+ * Function to run the flag liveness analysis over the program in instruction
+ * memory, and mark the instructions whose flags updates can be skipped.
+ */
+void
+analyzeFlagLiveness() {
+    buildControlFlowGraph();
+
+    bool live_in[TOTAL_INSTRUCTION_SLOTS] = {false};
+    bool live_out[TOTAL_INSTRUCTION_SLOTS] = {false};
+    bool changed = true;
+    int b, e;
+
+    // Flags only become live, so iterate until nothing changes.
+    while (changed) {
+        changed = false;
+        for (b = 0; b < CFG_BLOCK_COUNT; b++) {
+            live_out[b] = CFG_BLOCKS[b].is_exit;
+        }
+        for (e = 0; e < CFG_EDGE_COUNT; e++) {
+            if (live_in[CFG_EDGES[e].to_block]) {
+                live_out[CFG_EDGES[e].from_block] = true;
+            }
+        }
+        for (b = CFG_BLOCK_COUNT - 1; b >= 0; b--) {
+            bool live = computeBlockFlagLiveness(&CFG_BLOCKS[b], live_out[b], false);
+            if (live != live_in[b]) {
+                live_in[b] = live;
+                changed = true;
+            }
+        }
+    }
+
+    memset(FLAGS_DEAD, 0, sizeof(FLAGS_DEAD));
+    for (b = 0; b < CFG_BLOCK_COUNT; b++) {
+        computeBlockFlagLiveness(&CFG_BLOCKS[b], live_out[b], true);
+    }
+
+    int flag_setters = 0;
+    int dead = 0;
+    int i;
+    for (i = 0; i < CFG_INSTRUCTION_COUNT; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        if (instr->binary_opcode != 0 && writesAllFlags(&instr->instr_attr)) {
+            flag_setters++;
+            dead += FLAGS_DEAD[instr->position];
+        }
+    }
+    printf("Flag liveness: skipping the flags update of %d of %d flag setting instructions.\n",
+            dead, flag_setters);
+}
@@ -10,13 +10,29 @@
 #include <math.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <pthread.h>
 
 extern SIZE_TYPE GPRS[MAX_GPRS];
 
 void setFlagsRegister(SIZE_TYPE val1, SIZE_TYPE val2, SIZE_TYPE result);
 bool getFlagStatusFromFlagsRegister(status_flags input_flag);
+bool isConditionSatisfied(condition_codes condition);
 bool isSubtract = false;
 void checkValidMemoryAccess(SIZE_TYPE memory_address);
+void checkValidMemoryRange(SIZE_TYPE memory_address, SIZE_TYPE count);
+
+#include "cpu_debugger.c"
+#include "cpu_packed.c"
+#include "cpu_fpu.c"
+#include "cpu_profiler.c"
+#include "cpu_source.c"
+#include "cpu_cache.c"
+#include "cpu_linker.c"
+#include "cpu_optimizer.c"
+#include "cpu_cfg.c"
+#include "cpu_liveness.c"
+#include "cpu_shadow_stack.c"
 
 //#############################################################################
 ////////////////////////// General Functions Section //////////////////////////
@@ -66,23 +82,76 @@ writeIntoMemory(SIZE_TYPE start_index, int num_bytes, data_ptr data) {
     for (i = 0, index = start_index; i < num_bytes; i++, index++) {
         MEMORY[index] = data[i];
     }
+    notifyMemoryWrite(start_index, num_bytes);
+}
+
+/*
+ * Function to read the word at the given memory address, which need not be
+ * aligned. The address must already be validated.
+ */
+static inline SIZE_TYPE
+loadMemoryWord(SIZE_TYPE memory_address) {
+    SIZE_TYPE value;
+    memcpy(&value, &MEMORY[memory_address], NUM_BYTES_IN_WORD);
+    return value;
+}
+
+/*
+ * Function to write the word at the given memory address, which need not be
+ * aligned. The address must already be validated.
+ */
+static inline void
+storeMemoryWord(SIZE_TYPE memory_address, SIZE_TYPE value) {
+    memcpy(&MEMORY[memory_address], &value, NUM_BYTES_IN_WORD);
 }
 
 
+// Instruction memory address the assembler saves the next word at. It is
+// INSTR_MEMORY_PTR, except in the parallel assembler threads which each fill
+// their own part of instruction memory.
+__thread SIZE_TYPE *ASSEMBLY_PTR = &INSTR_MEMORY_PTR;
+
+// Print every saved word. Turned off by the parallel assembler, whose threads
+// would interleave the listing.
+bool ASSEMBLY_LISTING = true;
+
 /*
  * Function to save the binary opcode to instruction memory region.
  */
 void
 saveInstructionToMemory(SIZE_TYPE opcode) {
-    writeIntoMemory(INSTR_MEMORY_PTR, NUM_BYTES_IN_WORD, (data_ptr) &opcode);
-    printf("====> Memory Location: %u, Binary Opcode: %x\n", INSTR_MEMORY_PTR, opcode);
-    INSTR_MEMORY_PTR = INSTR_MEMORY_PTR + NUM_BYTES_IN_WORD;
+    uint32_t instruction = (uint32_t) opcode;
+    writeIntoMemory(*ASSEMBLY_PTR, INSTR_SIZE, (data_ptr) &instruction);
+    if (ASSEMBLY_LISTING) {
+        printf("====> Memory Location: %" PRIuW ", Binary Opcode: %x\n", *ASSEMBLY_PTR, instruction);
+    }
+    *ASSEMBLY_PTR = *ASSEMBLY_PTR + INSTR_SIZE;
+}
+
+/*
+ * Function to save a wide immediate constant to the extension word following
+ * the instruction. The extension word is a full register wide.
+ */
+void
+saveExtensionWordToMemory(SIZE_TYPE constant) {
+    writeIntoMemory(*ASSEMBLY_PTR, NUM_BYTES_IN_WORD, (data_ptr) &constant);
+    if (ASSEMBLY_LISTING) {
+        printf("====> Memory Location: %" PRIuW ", Extension Word: %" PRIxW "\n", *ASSEMBLY_PTR, constant);
+    }
+    *ASSEMBLY_PTR = *ASSEMBLY_PTR + NUM_BYTES_IN_WORD;
 }
 
 
 /*
  * Function to display contents of all registers.
  */
+// Width of a register in hex digits, for aligned output.
+#if WORD_SIZE == 64
+#define REG_WIDTH "18"
+#else
+#define REG_WIDTH "10"
+#endif
+
 void
 displayRegisters() {
     printf("\n--------------------------------Displaying Register contents---------------------------\n");
@@ -91,16 +160,22 @@ displayRegisters() {
     
     int i;
     for (i = 0; i < MAX_GPRS; i++) {
-        printf("R%u \t\t : 0x%10x : %25u : %20d \n", i, GPRS[i], GPRS[i], GPRS[i]); 
+        printf("R%u \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", i, GPRS[i], GPRS[i], GPRS[i]);
+    }
+    printf("HI \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", HI, HI, HI);
+    printf("LO \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", LO, LO, LO);
+    printf("\nMDR \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", MDR, MDR, MDR);
+    printf("MAR \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", MAR, MAR, MAR);
+    printf("FLAGS \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", FLAGS, FLAGS, FLAGS);
+    printf("PC \t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", PC, PC, PC);
+    printf("SP R14\t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", GPRS[14], GPRS[14], GPRS[14]);
+    printf("FP R15\t\t : 0x%" REG_WIDTH PRIxW " : %25" PRIuW " : %20" PRIdW " \n", GPRS[15], GPRS[15], GPRS[15]);
+
+    // Floating point registers, four per line
+    printf("\n");
+    for (i = 0; i < MAX_FPRS; i++) {
+        printf("F%-2u : %-14g%s", i, FPRS[i], (i % 4 == 3) ? "\n" : "  ");
     }
-    printf("HI \t\t : 0x%10x : %25u : %20d \n", HI, HI, HI);
-    printf("LO \t\t : 0x%10x : %25u : %20d \n", LO, LO, LO);
-    printf("\nMDR \t\t : 0x%10x : %25u : %20d \n", MDR, MDR, MDR);
-    printf("MAR \t\t : 0x%10x : %25u : %20d \n", MAR, MAR, MAR);
-    printf("FLAGS \t\t : 0x%10x : %25u : %20d \n", FLAGS, FLAGS, FLAGS);
-    printf("PC \t\t : 0x%10x : %25u : %20d \n", PC, PC, PC);
-    printf("SP R14\t\t : 0x%10x : %25u : %20d \n", GPRS[14], GPRS[14], GPRS[14]);
-    printf("FP R15\t\t : 0x%10x : %25u : %20d \n", GPRS[15], GPRS[15], GPRS[15]);
 
     // Explicitly display the flags values
     bool sf_status = getFlagStatusFromFlagsRegister(SF);
@@ -141,12 +216,13 @@ displayMemoryInRange(SIZE_TYPE start_index, SIZE_TYPE end_index) {
     }
     */
     // Display memory contents
-    printf("Displaying Memory contents (%#x to %#x)\n", start_index, final_index);
+    printf("Displaying Memory contents (%#" PRIxW " to %#" PRIxW ")\n", start_index, final_index);
     printf("---------------------------------------------------------------------------\n");
     printf("Location(Hex) \t : \t Contents(Hex) \t : \t Contents(Decimal)\n");
     printf("---------------------------------------------------------------------------\n");
-    for (i = final_index; i >= start_index; i = i - 4) {
-        printf("0x%x     \t : \t 0x%.8x     \t : \t %16d \n", i, readFromMemory(i, 4), readFromMemory(i, 4));
+    for (i = final_index; i >= start_index; i = i - NUM_BYTES_IN_WORD) {
+        SIZE_TYPE value = readFromMemory(i, NUM_BYTES_IN_WORD);
+        printf("0x%x     \t : \t 0x%.*" PRIxW "     \t : \t %16" PRIdW " \n", i, NUM_BYTES_IN_WORD * 2, value, value);
     }
     printf("---------------------------------------------------------------------------\n\n");
     printf("---------------------------------------------------------------------------\n\n");
@@ -287,58 +363,69 @@ subtract(SIZE_TYPE val1, SIZE_TYPE val2) {
     return val2;
 }
 
-SIZE_TYPE tmpsubtract(SIZE_TYPE val1, SIZE_TYPE val2){
-    return add(val1, Twos_Complement(val2));
-}
-
 /*
- * Function to multiply two values
+ * Function to multiply two values. The full signed product is saved in HI:LO
+ * and the low word is returned.
  */
 SIZE_TYPE 
 multiply(SIZE_TYPE val1, SIZE_TYPE val2) {
-    SIZE_TYPE result = 0;
-    while (val2 != 0)                  // Iterate the loop till b == 0
-    {
-        if (val2 & 0x01)               // Bitwise & of the value of b with 01
-        {
-            result = result + val1;    // Add a to result if b is odd .
-        }
-        val1 <<= 1;                    // Left shifting the value contained in 'a' by 1
-                                       // Multiplies a by 2 for each loop
-        val2 >>= 1;                    // Right shifting the value contained in 'b' by 1.
-    }
-    return result;
+    SIGNED_DOUBLE_SIZE_TYPE product = (SIGNED_DOUBLE_SIZE_TYPE) (SIGNED_SIZE_TYPE) val1
+        * (SIGNED_SIZE_TYPE) val2;
+    HI = (SIZE_TYPE) ((DOUBLE_SIZE_TYPE) product >> WORD_SIZE);
+    LO = (SIZE_TYPE) product;
+    return LO;
+}
+
+/*
+ * Function to multiply two unsigned values. The full product is saved in
+ * HI:LO and the low word is returned.
+ */
+SIZE_TYPE
+multiplyUnsigned(SIZE_TYPE val1, SIZE_TYPE val2) {
+    DOUBLE_SIZE_TYPE product = (DOUBLE_SIZE_TYPE) val1 * val2;
+    HI = (SIZE_TYPE) (product >> WORD_SIZE);
+    LO = (SIZE_TYPE) product;
+    return LO;
 }
 
 /*
- * Function to perform divide operation.
+ * Function to perform signed divide operation val1 / val2. The quotient is
+ * saved in LO, the remainder in HI and the quotient is returned.
  */
 SIZE_TYPE 
 divide(SIZE_TYPE val1, SIZE_TYPE val2) {
-    SIZE_TYPE c=0,sign=0;
+    SIGNED_SIZE_TYPE dividend = (SIGNED_SIZE_TYPE) val1;
+    SIGNED_SIZE_TYPE divisor = (SIGNED_SIZE_TYPE) val2;
 
-    if(val1 < 0) {
-       val1 = Twos_Complement(val1);
-           sign ^= 0x01;
-   }
+    if (divisor == 0) {
+        printf("ERROR: Division by zero.\n");
+        exit(0);
+    }
 
-   if(val2 < 0) {
-       val2 = Twos_Complement(val2);
-       sign ^= 0x01;
-   }
+    // Most negative value / -1 overflows on the host, the result wraps.
+    if (divisor == -1) {
+        LO = Twos_Complement(val1);
+        HI = 0;
+    } else {
+        LO = (SIZE_TYPE) (dividend / divisor);
+        HI = (SIZE_TYPE) (dividend % divisor);
+    }
+    return LO;
+}
 
-   if(val2 != 0) {
-       while (val1 >= val2) {
-           val1 = tmpsubtract(val1,val2);
-           c = add(c,1);
-       }
-       HI = val1 ; // this gives mod answer
-   }
-   if (sign) {
-       c = Twos_Complement(c);
-   }
-   LO = c;
-   return c;
+/*
+ * Function to perform unsigned divide operation val1 / val2. The quotient is
+ * saved in LO, the remainder in HI and the quotient is returned.
+ */
+SIZE_TYPE
+divideUnsigned(SIZE_TYPE val1, SIZE_TYPE val2) {
+    if (val2 == 0) {
+        printf("ERROR: Division by zero.\n");
+        exit(0);
+    }
+    LO = val1 / val2;
+    HI = val1 % val2;
+    return LO;
 }
 
 
@@ -377,15 +464,77 @@ srl(SIZE_TYPE val1, SIZE_TYPE val2) {
  */
 SIZE_TYPE
 sra(SIZE_TYPE val1, SIZE_TYPE val2){
-    // Get the MSB of val2
-    int msb_temp = val2 >> (WORD_SIZE - 1);
-    int z = 0x00;
-    if (msb_temp) {
-        z = ~z;
+    // Fill the vacated upper bits with the MSB of val2
+    SIZE_TYPE msb_temp = val2 >> (WORD_SIZE - 1);
+    SIZE_TYPE temp = srl(val1, val2);
+    if (msb_temp && val1 != 0) {
+        temp = temp | ~srl(val1, ~(SIZE_TYPE) 0);
     }
-    int temp = srl(val1, val2);
-    int x = sll(z, val1);
-    return (x | temp);
+    return temp;
+}
+
+// Host intrinsics matching the register width.
+#if WORD_SIZE == 64
+#define HOST_POPCOUNT(x)    __builtin_popcountll(x)
+#define HOST_CLZ(x)         __builtin_clzll(x)
+#define HOST_CTZ(x)         __builtin_ctzll(x)
+#define HOST_BSWAP(x)       __builtin_bswap64(x)
+#else
+#define HOST_POPCOUNT(x)    __builtin_popcount(x)
+#define HOST_CLZ(x)         __builtin_clz(x)
+#define HOST_CTZ(x)         __builtin_ctz(x)
+#define HOST_BSWAP(x)       __builtin_bswap32(x)
+#endif
+
+/*
+ * Function to count the set bits of a value.
+ */
+SIZE_TYPE
+popcount(SIZE_TYPE val) {
+    return HOST_POPCOUNT(val);
+}
+
+/*
+ * Function to count the leading zero bits of a value. Returns WORD_SIZE for 0.
+ */
+SIZE_TYPE
+countLeadingZeros(SIZE_TYPE val) {
+    return (val == 0) ? WORD_SIZE : HOST_CLZ(val);
+}
+
+/*
+ * Function to count the trailing zero bits of a value. Returns WORD_SIZE for 0.
+ */
+SIZE_TYPE
+countTrailingZeros(SIZE_TYPE val) {
+    return (val == 0) ? WORD_SIZE : HOST_CTZ(val);
+}
+
+/*
+ * Function to reverse the byte order of a value.
+ */
+SIZE_TYPE
+byteSwap(SIZE_TYPE val) {
+    return HOST_BSWAP(val);
+}
+
+/*
+ * Function to rotate val2 left by val1 positions. Compilers turn this pattern
+ * into a single host rotate instruction.
+ */
+SIZE_TYPE
+rotateLeft(SIZE_TYPE val1, SIZE_TYPE val2) {
+    val1 = val1 & (WORD_SIZE - 1);
+    return (val2 << val1) | (val2 >> ((WORD_SIZE - val1) & (WORD_SIZE - 1)));
+}
+
+/*
+ * Function to rotate val2 right by val1 positions.
+ */
+SIZE_TYPE
+rotateRight(SIZE_TYPE val1, SIZE_TYPE val2) {
+    val1 = val1 & (WORD_SIZE - 1);
+    return (val2 >> val1) | (val2 << ((WORD_SIZE - val1) & (WORD_SIZE - 1)));
 }
  
 
@@ -404,6 +553,11 @@ sra(SIZE_TYPE val1, SIZE_TYPE val2){
  */
 void
 setFlagsRegister(SIZE_TYPE val1, SIZE_TYPE val2, SIZE_TYPE result) {
+    // No later instruction reads these flags.
+    if (skip_flags_update) {
+        return;
+    }
+
     // Set 7th bit: SF
     // MSB of result = 1, SF = 1 else SF = 0
     int res_msb = (result >> (WORD_SIZE - 1)) & 0x01;
@@ -421,9 +575,9 @@ setFlagsRegister(SIZE_TYPE val1, SIZE_TYPE val2, SIZE_TYPE result) {
     // Subtraction:
     //  if (a > 0 && b < 0 && res < 0) || (a < 0 && b > 0 && res > 0)
     //  result = 1 else 0
-    int val1_signed = (int) val1;
-    int val2_signed = (int) val2;
-    int result_signed = (int) result;
+    SIGNED_SIZE_TYPE val1_signed = (SIGNED_SIZE_TYPE) val1;
+    SIGNED_SIZE_TYPE val2_signed = (SIGNED_SIZE_TYPE) val2;
+    SIGNED_SIZE_TYPE result_signed = (SIGNED_SIZE_TYPE) result;
     bool sum_condition = ((val1_signed > 0 && val2_signed > 0 && result_signed <= 0) || (val1_signed < 0 && val2_signed < 0 && result_signed >= 0));
     bool sub_condition = ((val2_signed > 0 && val1_signed < 0 && result_signed < 0) || (val2_signed < 0 && val1_signed > 0 && result_signed > 0));
     if (isSubtract && sub_condition){
@@ -437,16 +591,8 @@ setFlagsRegister(SIZE_TYPE val1, SIZE_TYPE val2, SIZE_TYPE result) {
     // Set 4th bit: PF
     // PF = 1 if result has even parity else 0
     // Count the one's in the result
-    SIZE_TYPE count_ones = 0;
-    int i =0;
-    for (i = 0; i < WORD_SIZE; i++) {
-        SIZE_TYPE res_temp = result >> i;
-        int val = res_temp & 0x01;
-        count_ones += val;
-    }
-    SIZE_TYPE rem = divide(count_ones, 2);
-    // Divide instruction stores the mod in HI register
-    if (HI != 0) {
+    SIZE_TYPE count_ones = popcount(result);
+    if (count_ones & 0x01) {
         // Odd parity, set PF = 1
         FLAGS = FLAGS | HEX_PF; 
     } else {
@@ -745,7 +891,7 @@ executeSRA(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
 void 
 executeSRAI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
     SIZE_TYPE op2 = *ptr;
-    SIZE_TYPE result = sra(op2, constant);
+    SIZE_TYPE result = sra(constant, op2);
     *ptr = result;
     setFlagsRegister(constant, op2, result);
 }
@@ -756,7 +902,7 @@ executeSRAI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
 void
 executePush(SIZE_TYPE* arg1){
     SIZE_TYPE op1 = *arg1;
-    SP = SP - 4;
+    SP = SP - NUM_BYTES_IN_WORD;
     writeIntoMemory(SP, NUM_BYTES_IN_WORD, (data_ptr) &op1);
 }
 
@@ -766,7 +912,7 @@ executePush(SIZE_TYPE* arg1){
 void
 executePop(SIZE_TYPE* reg) {
     *reg = readFromMemory(SP, NUM_BYTES_IN_WORD);
-    SP = SP + 4;
+    SP = SP + NUM_BYTES_IN_WORD;
 }
 
 /*
@@ -796,7 +942,7 @@ executeAddI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
  * Function to execute sub command.
 */
 void 
-executeSub(int* arg1, int* arg2) {
+executeSub(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
     SIZE_TYPE op1 = *arg1;
     SIZE_TYPE op2 = *arg2;
     SIZE_TYPE result = subtract (op1, op2);
@@ -819,7 +965,7 @@ executeSubI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
  * Function to execute addi command.
  */
 void 
-executeMul(int* arg1, int* arg2) {
+executeMul(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
     SIZE_TYPE op1 = *arg1;
     SIZE_TYPE op2 = *arg2;
     SIZE_TYPE result = multiply (op1, op2);
@@ -842,7 +988,7 @@ executeMulI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
  * Function to execute division.
  */
 void 
-executeDiv(int* arg1, int* arg2) {
+executeDiv(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
     SIZE_TYPE op1 = *arg1;
     SIZE_TYPE op2 = *arg2;
     SIZE_TYPE result = divide (op1, op2);
@@ -862,13 +1008,26 @@ executeDivI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
 }
 
 /*
- * Function to execute modulas.
+ * Function to execute unsigned division.
  */
 void
-executeMod(int* arg1, int* arg2) {
+executeDivU(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
     SIZE_TYPE op1 = *arg1;
     SIZE_TYPE op2 = *arg2;
-    SIZE_TYPE result = divide (op1, op2);
+    SIZE_TYPE result = divideUnsigned (op1, op2);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
+}
+
+/*
+ * Function to execute modulas. The remainder of the division is left in HI.
+ */
+void
+executeMod(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    divide (op1, op2);
+    SIZE_TYPE result = HI;
     *arg2 = result;
     setFlagsRegister(op1, op2, result);
 }
@@ -879,233 +1038,659 @@ executeMod(int* arg1, int* arg2) {
 void 
 executeModI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
     SIZE_TYPE op2 = *ptr;
-    SIZE_TYPE result = divide (constant, op2);
+    divide (constant, op2);
+    SIZE_TYPE result = HI;
     *ptr = result;
     setFlagsRegister(constant, op2, result);
 }
 
 /*
- * Function to execute MOV instruction.
+ * Function to execute MULT command. The full signed product of the two
+ * operands is saved in HI:LO; the operands and FLAGS are not modified.
  */
 void
-executeMov(SIZE_TYPE *op1, SIZE_TYPE* op2) {
-    // Move the contents of op1 to op2.
-    *op2 = *op1;
+executeMult(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    multiply(*arg1, *arg2);
 }
 
 /*
- * Function to execute MOVI command.
+ * Function to execute MULTU command. The full unsigned product of the two
+ * operands is saved in HI:LO; the operands and FLAGS are not modified.
  */
 void
-executeMovI(SIZE_TYPE constant, SIZE_TYPE *ptr) {
-    // Copy the constant value to the ptr location.
-    *ptr = constant;
+executeMultU(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    multiplyUnsigned(*arg1, *arg2);
 }
 
 /*
- * Function to execute LEA instruction.
+ * Function to execute MFHI command.
  */
 void
-executeLea(SIZE_TYPE addr, SIZE_TYPE reg) {
-    SIZE_TYPE *reg_ptr = (SIZE_TYPE *) &GPRS[reg];
-    *reg_ptr = addr;
+executeMfhi(SIZE_TYPE* reg) {
+    *reg = HI;
 }
 
-
 /*
- * Function to execute CALL command.
+ * Function to execute MFLO command.
  */
 void
-executeCall(int label_offset) {
-    // Push the return address to stack
-    executePush(&PC);
-
-    // Set the new value of PC = PC + label_offset * 4
-    PC = PC + (label_offset * 4);
+executeMflo(SIZE_TYPE* reg) {
+    *reg = LO;
 }
 
 /*
- * Function to execute JMP command.
+ * Function to execute CMP command. It computes arg2 - arg1 like SUB but only
+ * updates the FLAGS register; neither operand is modified.
  */
 void
-executeJmp(int label_offset) {
-    // Set the new value of PC = PC + label_offset * 4
-	PC = PC + (label_offset * 4);  
+executeCmp(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = subtract (op1, op2);
+    setFlagsRegister(op1, op2, result);
 }
 
 /*
- * Function to execute JE command. It checks the status of ZF.
+ * Function to execute CMPI command.
  */
 void
-executeJE(int label_offset) {
-    bool ZeroF = getFlagStatusFromFlagsRegister(ZF);
-	if (ZeroF) {
-		PC = PC + (label_offset * 4); 
-	}     
+executeCmpI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
+    SIZE_TYPE op2 = *ptr;
+    SIZE_TYPE result = subtract (constant, op2);
+    setFlagsRegister(constant, op2, result);
 }
 
 /*
- * Function to execute JNE command.
+ * Function to execute TEST command. It computes arg2 & arg1 like AND but only
+ * updates the FLAGS register; neither operand is modified.
  */
 void
-executeJNE(int label_offset) {
-    bool ZeroF = getFlagStatusFromFlagsRegister(ZF);
-	if (!ZeroF) {
-		PC = PC + (label_offset * 4); 
-	}     
+executeTest(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = and (op1, op2);
+    setFlagsRegister(op1, op2, result);
 }
 
 /*
- * Function to execute JS command.
+ * Function to execute TESTI command.
  */
 void
-executeJS(int label_offset) {
-    bool SignedF = getFlagStatusFromFlagsRegister(SF);
-	if (SignedF) {
-		PC = PC + (label_offset * 4); 
-	}     
+executeTestI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
+    SIZE_TYPE op2 = *ptr;
+    SIZE_TYPE result = and (constant, op2);
+    setFlagsRegister(constant, op2, result);
 }
 
 /*
- * Function to execute JNS command. It checks the SF.
+ * Function to execute packed (SIMD) commands. The operation is applied to
+ * every 8-bit/16-bit lane of arg2 and arg1, and the result is saved in arg2.
+ * Packed instructions do not modify the FLAGS register.
  */
 void
-executeJNS(int label_offset) {
-    bool SignedF = getFlagStatusFromFlagsRegister(SF);
-	if (!SignedF) {
-		PC = PC + (label_offset * 4); 
-	}     
+executePacked(char *command, SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result;
+
+    if (strcmp(command, PADDB) == 0) {
+        result = packedOperation(LANE_ADD, op1, op2, 8);
+    } else if (strcmp(command, PADDH) == 0) {
+        result = packedOperation(LANE_ADD, op1, op2, 16);
+    } else if (strcmp(command, PSUBB) == 0) {
+        result = packedOperation(LANE_SUB, op1, op2, 8);
+    } else if (strcmp(command, PSUBH) == 0) {
+        result = packedOperation(LANE_SUB, op1, op2, 16);
+    } else if (strcmp(command, PADDUSB) == 0) {
+        result = packedOperation(LANE_ADDUS, op1, op2, 8);
+    } else if (strcmp(command, PADDUSH) == 0) {
+        result = packedOperation(LANE_ADDUS, op1, op2, 16);
+    } else if (strcmp(command, PSUBUSB) == 0) {
+        result = packedOperation(LANE_SUBUS, op1, op2, 8);
+    } else if (strcmp(command, PSUBUSH) == 0) {
+        result = packedOperation(LANE_SUBUS, op1, op2, 16);
+    } else if (strcmp(command, PCMPEQB) == 0) {
+        result = packedOperation(LANE_CMPEQ, op1, op2, 8);
+    } else if (strcmp(command, PCMPEQH) == 0) {
+        result = packedOperation(LANE_CMPEQ, op1, op2, 16);
+    } else if (strcmp(command, PCMPGTB) == 0) {
+        result = packedOperation(LANE_CMPGT, op1, op2, 8);
+    } else if (strcmp(command, PCMPGTH) == 0) {
+        result = packedOperation(LANE_CMPGT, op1, op2, 16);
+    } else {
+        result = packedShuffleBytes(op1, op2);
+    }
+    *arg2 = result;
 }
 
 /*
- * Function to execute JG (signed) command. The instruction gets executed
- * after checking the following flags:
- *  ~(SF ^ OF) & ~ZF
+ * Function to execute VLOAD command.
  */
 void
-executeJG(int label_offset) {
-    bool SignedF = getFlagStatusFromFlagsRegister(SF);
-    bool OverflowF = getFlagStatusFromFlagsRegister(OF);
-    bool ZeroF = getFlagStatusFromFlagsRegister(ZF);
-    
-    if (!ZeroF && !(SignedF ^ OverflowF)) {
-		PC = PC + (label_offset * 4); 
-	}
+executeVLoad(int reg_to_load, SIZE_TYPE memory_addr) {
+    checkValidMemoryRange(memory_addr, VECTOR_SIZE);
+    vectorLoad(reg_to_load, memory_addr);
+    MAR = memory_addr;
+    MDR = GPRS[reg_to_load];
 }
 
 /*
- * Function to execute JGE (signed) command. The instruction gets executed
- * after checking the following status condition:
- *  ~(SF ^ OF)
+ * Function to execute VSTORE command.
  */
 void
-executeJGE(int label_offset) {
-    bool SignedF = getFlagStatusFromFlagsRegister(SF);
-    bool OverflowF = getFlagStatusFromFlagsRegister(OF);
-	
-    if( !(SignedF ^ OverflowF)) {
-		PC = PC + (label_offset * 4); 
-	}
+executeVStore(int reg_to_store, SIZE_TYPE memory_addr) {
+    checkValidMemoryRange(memory_addr, VECTOR_SIZE);
+    vectorStore(reg_to_store, memory_addr);
+    MAR = memory_addr;
+    MDR = GPRS[reg_to_store];
 }
 
 /*
- * Function to execute JL command. The instruction gets executed after checking
- * the following status condition:
- *  (SF ^ OF)
+ * Function to execute FLOAD.S/FLOAD.D commands.
  */
 void
-executeJL(int label_offset) {
-    bool SignedF = getFlagStatusFromFlagsRegister(SF);
-    bool OverflowF = getFlagStatusFromFlagsRegister(OF);
-
-	if (SignedF ^ OverflowF) {
-		PC = PC + (label_offset * 4); 
-	}
+executeFLoad(int reg_to_load, SIZE_TYPE memory_addr, bool is_single) {
+    int num_bytes = is_single ? sizeof(float) : sizeof(double);
+    checkValidMemoryRange(memory_addr, num_bytes);
+    FPRS[reg_to_load] = readFloatFromMemory(memory_addr, is_single);
+    MAR = memory_addr;
+    // MDR holds the bytes that were accessed, up to one word.
+    MDR = readFromMemory(memory_addr, num_bytes < NUM_BYTES_IN_WORD ? num_bytes : NUM_BYTES_IN_WORD);
 }
 
 /*
- * Function to execute JLE command. The instruction gets executed after checking
- * the following status condition:
- *  (SF ^ OF) | ZF
+ * Function to execute FSTORE.S/FSTORE.D commands.
  */
 void
-executeJLE(int label_offset) {
-    bool SignedF = getFlagStatusFromFlagsRegister(SF);
-    bool OverflowF = getFlagStatusFromFlagsRegister(OF);
-    bool ZeroF = getFlagStatusFromFlagsRegister(ZF);
-
-	if((SignedF ^ OverflowF) || ZeroF) {
-		PC = PC + (label_offset * 4); 
-	}
+executeFStore(int reg_to_store, SIZE_TYPE memory_addr, bool is_single) {
+    int num_bytes = is_single ? sizeof(float) : sizeof(double);
+    checkValidMemoryRange(memory_addr, num_bytes);
+    writeFloatIntoMemory(memory_addr, FPRS[reg_to_store], is_single);
+    MAR = memory_addr;
+    // MDR holds the bytes that were accessed, up to one word.
+    MDR = readFromMemory(memory_addr, num_bytes < NUM_BYTES_IN_WORD ? num_bytes : NUM_BYTES_IN_WORD);
 }
 
 /*
- * Function to execute RET command.
+ * Function to execute floating point arithmetic commands. The result of
+ * arg2 op arg1 (op arg1 for FSQRT) is saved in arg2. FLAGS are not modified.
  */
 void
-executeRet() {
-    executePop(&PC);
+executeFloat(fp_operations operation, bool is_single, double *arg1, double *arg2) {
+    *arg2 = floatOperation(operation, *arg1, *arg2, is_single);
 }
 
-
-
-//#############################################################################
-///////////////////// Decode and Execution Section ////////////////////////////
-//#############################################################################
+/*
+ * Function to execute FCMP.S/FCMP.D commands. arg2 is compared with arg1 and
+ * only the FLAGS register is updated.
+ */
+void
+executeFCmp(bool is_single, double *arg1, double *arg2) {
+    if (is_single) {
+        setFlagsFromFloatCompare(roundToSingle(*arg1), roundToSingle(*arg2));
+    } else {
+        setFlagsFromFloatCompare(*arg1, *arg2);
+    }
+}
 
 /*
- * Function to compute memory address in case of generic memory addressing operand.
+ * Function to execute POPCNT command.
  */
-SIZE_TYPE
-computeMemoryAddressFromOpcode(struct instruction_attr* instr_attr_ptr) {
-    SIZE_TYPE address;
-    int base_reg = instr_attr_ptr->base_register;
-    int index_reg = instr_attr_ptr->index_register;
-    int scale = instr_attr_ptr->scale;
-    int offset = instr_attr_ptr->offset;
+void
+executePopcnt(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = popcount (op1);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
+}
 
-    address = GPRS[base_reg] + (GPRS[index_reg] * scale) + offset;
-    checkValidMemoryAccess(address);
-    return address;
+/*
+ * Function to execute CLZ command.
+ */
+void
+executeClz(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = countLeadingZeros (op1);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
 }
 
 /*
- * Function to execute Load/Store i.e. memory type instructions.
+ * Function to execute CTZ command.
  */
 void
-executeMemoryTypeInstructions(struct instruction_attr* instr_attr_ptr) {
-    char *command = instr_attr_ptr->instruction;
-    
-    // Compute memory address
-    SIZE_TYPE memory_address = computeMemoryAddressFromOpcode(instr_attr_ptr);
-    int reg = instr_attr_ptr->operand_register;
+executeCtz(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = countTrailingZeros (op1);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
+}
 
-    // Load command
-    if (strcmp(command, LOAD) == 0) {
-        executeLoad(reg, memory_address);
-    }
-    // Store command
-    if (strcmp(command, STORE) == 0) {
-        executeStore(reg, memory_address);
-    }
-    // LEA command
-    if (strcmp(command, LEA) == 0) {
-        executeLea(memory_address, reg);
-    }
+/*
+ * Function to execute BSWAP command.
+ */
+void
+executeBswap(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = byteSwap (op1);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
 }
 
 /*
- * Function to execute Stack instructions. These instruction formats are
- * supported:
- *  STACK_REG: e.g. push r1
- *  STACK_REG: e.g. pop r2
+ * Function to execute ROL command.
  */
 void
-executeStackInstructions(struct instruction_attr* instr_attr_ptr) {
-    char *command = instr_attr_ptr->instruction;
-    int reg = instr_attr_ptr->operand_register;
-    int *address[1];
-    // Find parameters based on specific format reg-reg/reg-mem/mem-reg.
+executeRol(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = rotateLeft (op1, op2);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
+}
+
+/*
+ * Function to execute ROLI command.
+ */
+void
+executeRolI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
+    SIZE_TYPE op2 = *ptr;
+    SIZE_TYPE result = rotateLeft (constant, op2);
+    *ptr = result;
+    setFlagsRegister(constant, op2, result);
+}
+
+/*
+ * Function to execute ROR command.
+ */
+void
+executeRor(SIZE_TYPE* arg1, SIZE_TYPE* arg2) {
+    SIZE_TYPE op1 = *arg1;
+    SIZE_TYPE op2 = *arg2;
+    SIZE_TYPE result = rotateRight (op1, op2);
+    *arg2 = result;
+    setFlagsRegister(op1, op2, result);
+}
+
+/*
+ * Function to execute RORI command.
+ */
+void
+executeRorI(SIZE_TYPE constant, SIZE_TYPE* ptr) {
+    SIZE_TYPE op2 = *ptr;
+    SIZE_TYPE result = rotateRight (constant, op2);
+    *ptr = result;
+    setFlagsRegister(constant, op2, result);
+}
+
+/*
+ * Function to execute MOV instruction.
+ */
+void
+executeMov(SIZE_TYPE *op1, SIZE_TYPE* op2) {
+    // Move the contents of op1 to op2.
+    *op2 = *op1;
+}
+
+/*
+ * Function to execute conditional MOV instructions. The contents of op1 are
+ * moved to op2 only if the condition holds; FLAGS is not modified.
+ */
+void
+executeCMov(condition_codes condition, SIZE_TYPE *op1, SIZE_TYPE *op2) {
+    if (isConditionSatisfied(condition)) {
+        *op2 = *op1;
+    }
+}
+
+/*
+ * Function to execute MOVI command.
+ */
+void
+executeMovI(SIZE_TYPE constant, SIZE_TYPE *ptr) {
+    // Copy the constant value to the ptr location.
+    *ptr = constant;
+}
+
+/*
+ * Function to execute LUI command. The constant replaces bits 16-31 of the
+ * register and the other bits are preserved, so that "movi $low, reg" followed
+ * by "lui $high, reg" builds a full 32-bit constant.
+ */
+void
+executeLUI(SIZE_TYPE constant, SIZE_TYPE *ptr) {
+    *ptr = (*ptr & ~((SIZE_TYPE) 0xffff << 16)) | ((constant & 0xffff) << 16);
+}
+
+/*
+ * Function to execute LEA instruction.
+ */
+void
+executeLea(SIZE_TYPE addr, SIZE_TYPE reg) {
+    SIZE_TYPE *reg_ptr = (SIZE_TYPE *) &GPRS[reg];
+    *reg_ptr = addr;
+}
+
+
+/*
+ * Function to verify that a block of count bytes starting at memory_address
+ * is valid data memory. The valid range is contiguous, so checking both ends
+ * validates the whole block.
+ */
+void
+checkValidMemoryRange(SIZE_TYPE memory_address, SIZE_TYPE count) {
+    if (count > MEMORY_SIZE) {
+        printf("ERROR: Invalid Memory Block size '%" PRIuW "'.\n", count);
+        exit(0);
+    }
+    checkValidMemoryAccess(memory_address);
+    checkValidMemoryAccess(memory_address + count - 1);
+}
+
+/*
+ * Function to execute MEMCPY command. Copies count bytes from src to dest in a
+ * single host memmove, so overlapping blocks are handled. Like "rep movs", the
+ * src/dest registers are advanced past the block and count is cleared.
+ */
+void
+executeMemcpy(SIZE_TYPE *src, SIZE_TYPE *dest, SIZE_TYPE *count) {
+    SIZE_TYPE num_bytes = *count;
+    if (num_bytes == 0) {
+        return;
+    }
+    checkValidMemoryRange(*src, num_bytes);
+    checkValidMemoryRange(*dest, num_bytes);
+
+    memmove(&MEMORY[*dest], &MEMORY[*src], num_bytes);
+    notifyMemoryWrite(*dest, num_bytes);
+
+    *src = *src + num_bytes;
+    *dest = *dest + num_bytes;
+    *count = 0;
+}
+
+/*
+ * Function to execute MEMSET command. Fills count bytes at dest with the low
+ * byte of value in a single host memset. Like "rep stos", the dest register is
+ * advanced past the block and count is cleared.
+ */
+void
+executeMemset(SIZE_TYPE *value, SIZE_TYPE *dest, SIZE_TYPE *count) {
+    SIZE_TYPE num_bytes = *count;
+    if (num_bytes == 0) {
+        return;
+    }
+    checkValidMemoryRange(*dest, num_bytes);
+
+    memset(&MEMORY[*dest], *value & 0xff, num_bytes);
+    notifyMemoryWrite(*dest, num_bytes);
+
+    *dest = *dest + num_bytes;
+    *count = 0;
+}
+
+/*
+ * Function to execute CALL command.
+ */
+void
+executeCall(int label_offset) {
+    // Push the return address to stack
+    pushReturnAddress(PC);
+
+    // Set the new value of PC = PC + label_offset * INSTR_SIZE
+    PC = PC + (label_offset * INSTR_SIZE);
+}
+
+/*
+ * Function to execute JMP command.
+ */
+void
+executeJmp(int label_offset) {
+    // Set the new value of PC = PC + label_offset * INSTR_SIZE
+	PC = PC + (label_offset * INSTR_SIZE);  
+}
+
+/*
+ * Function to check whether the given condition holds for the current FLAGS.
+ * The conditions are shared by the conditional jumps and conditional moves:
+ *  E:  ZF
+ *  NE: ~ZF
+ *  S:  SF
+ *  NS: ~SF
+ *  G:  ~(SF ^ OF) & ~ZF    (signed)
+ *  GE: ~(SF ^ OF)          (signed)
+ *  L:  (SF ^ OF)           (signed)
+ *  LE: (SF ^ OF) | ZF      (signed)
+ */
+bool
+isConditionSatisfied(condition_codes condition) {
+    bool SignedF = getFlagStatusFromFlagsRegister(SF);
+    bool OverflowF = getFlagStatusFromFlagsRegister(OF);
+    bool ZeroF = getFlagStatusFromFlagsRegister(ZF);
+
+    switch (condition) {
+        case COND_E:
+            return ZeroF;
+        case COND_NE:
+            return !ZeroF;
+        case COND_S:
+            return SignedF;
+        case COND_NS:
+            return !SignedF;
+        case COND_G:
+            return !ZeroF && !(SignedF ^ OverflowF);
+        case COND_GE:
+            return !(SignedF ^ OverflowF);
+        case COND_L:
+            return SignedF ^ OverflowF;
+        case COND_LE:
+            return (SignedF ^ OverflowF) || ZeroF;
+        default:
+            printf("ERROR: Unsupported condition code passed.\n");
+            exit(0);
+    }
+}
+
+/*
+ * Function to execute JE command. It checks the status of ZF.
+ */
+void
+executeJE(int label_offset) {
+	if (isConditionSatisfied(COND_E)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}     
+}
+
+/*
+ * Function to execute JNE command.
+ */
+void
+executeJNE(int label_offset) {
+	if (isConditionSatisfied(COND_NE)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}     
+}
+
+/*
+ * Function to execute JS command.
+ */
+void
+executeJS(int label_offset) {
+	if (isConditionSatisfied(COND_S)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}     
+}
+
+/*
+ * Function to execute JNS command. It checks the SF.
+ */
+void
+executeJNS(int label_offset) {
+	if (isConditionSatisfied(COND_NS)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}     
+}
+
+/*
+ * Function to execute JG (signed) command. The instruction gets executed
+ * after checking the following flags:
+ *  ~(SF ^ OF) & ~ZF
+ */
+void
+executeJG(int label_offset) {
+    if (isConditionSatisfied(COND_G)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}
+}
+
+/*
+ * Function to execute JGE (signed) command. The instruction gets executed
+ * after checking the following status condition:
+ *  ~(SF ^ OF)
+ */
+void
+executeJGE(int label_offset) {
+    if (isConditionSatisfied(COND_GE)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}
+}
+
+/*
+ * Function to execute JL command. The instruction gets executed after checking
+ * the following status condition:
+ *  (SF ^ OF)
+ */
+void
+executeJL(int label_offset) {
+	if (isConditionSatisfied(COND_L)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}
+}
+
+/*
+ * Function to execute JLE command. The instruction gets executed after checking
+ * the following status condition:
+ *  (SF ^ OF) | ZF
+ */
+void
+executeJLE(int label_offset) {
+	if (isConditionSatisfied(COND_LE)) {
+		PC = PC + (label_offset * INSTR_SIZE); 
+	}
+}
+
+/*
+ * Function to execute LOOP command. The counter register is decremented and
+ * the jump is taken till it reaches zero. FLAGS is not modified.
+ */
+void
+executeLoop(int counter_reg, int label_offset) {
+    GPRS[counter_reg] = GPRS[counter_reg] - 1;
+    if (GPRS[counter_reg] != 0) {
+        PC = PC + (label_offset * INSTR_SIZE);
+    }
+}
+
+/*
+ * Function to execute RET command.
+ */
+void
+executeRet() {
+    PC = popReturnAddress();
+}
+
+
+
+//#############################################################################
+///////////////////// Decode and Execution Section ////////////////////////////
+//#############################################################################
+
+/*
+ * Function to compute memory address in case of generic memory addressing operand.
+ */
+SIZE_TYPE
+computeMemoryAddressFromOpcode(struct instruction_attr* instr_attr_ptr) {
+    SIZE_TYPE address;
+    int base_reg = instr_attr_ptr->base_register;
+    int index_reg = instr_attr_ptr->index_register;
+    int scale = instr_attr_ptr->scale;
+    int offset = instr_attr_ptr->offset;
+
+    address = GPRS[base_reg] + (GPRS[index_reg] * scale) + offset;
+    checkValidMemoryAccess(address);
+    return address;
+}
+
+/*
+ * Function to compute the address of the memory operand of an ALU instruction
+ * (REG_MEM, MEM_REG and IMM_MEM formats), checking in one go that the whole
+ * word at it is in data/stack memory.
+ */
+static inline SIZE_TYPE
+computeMemoryOperandAddress(struct instruction_attr* instr_attr_ptr) {
+    SIZE_TYPE address = GPRS[instr_attr_ptr->base_register]
+        + (GPRS[instr_attr_ptr->index_register] * instr_attr_ptr->scale) + instr_attr_ptr->offset;
+    checkValidMemoryRange(address, NUM_BYTES_IN_WORD);
+    return address;
+}
+
+/*
+ * Function to execute Load/Store i.e. memory type instructions.
+ */
+void
+executeMemoryTypeInstructions(struct instruction_attr* instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    
+    // Compute memory address
+    SIZE_TYPE memory_address = computeMemoryAddressFromOpcode(instr_attr_ptr);
+    int reg = instr_attr_ptr->operand_register;
+
+    // Load command
+    if (strcmp(command, LOAD) == 0) {
+        executeLoad(reg, memory_address);
+    }
+    // Store command
+    if (strcmp(command, STORE) == 0) {
+        executeStore(reg, memory_address);
+    }
+    // LEA command
+    if (strcmp(command, LEA) == 0) {
+        executeLea(memory_address, reg);
+    }
+    // VLOAD command
+    if (strcmp(command, VLOAD) == 0) {
+        executeVLoad(reg, memory_address);
+    }
+    // VSTORE command
+    if (strcmp(command, VSTORE) == 0) {
+        executeVStore(reg, memory_address);
+    }
+    // FLOAD.S/FLOAD.D commands
+    if (strcmp(command, FLOADS) == 0 || strcmp(command, FLOADD) == 0) {
+        executeFLoad(reg, memory_address, strcmp(command, FLOADS) == 0);
+    }
+    // FSTORE.S/FSTORE.D commands
+    if (strcmp(command, FSTORES) == 0 || strcmp(command, FSTORED) == 0) {
+        executeFStore(reg, memory_address, strcmp(command, FSTORES) == 0);
+    }
+}
+
+/*
+ * Function to execute Stack instructions. These instruction formats are
+ * supported:
+ *  STACK_REG: e.g. push r1
+ *  STACK_REG: e.g. pop r2
+ */
+void
+executeStackInstructions(struct instruction_attr* instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    int reg = instr_attr_ptr->operand_register;
+    SIZE_TYPE *address[1];
+    // Find parameters based on specific format reg-reg/reg-mem/mem-reg.
     switch(instr_attr_ptr->format) {
         default:
             printf("ERROR: Unsupported instruction format for Stack instructions.\n");
@@ -1132,13 +1717,18 @@ executeStackInstructions(struct instruction_attr* instr_attr_ptr) {
  *  REG_REG: e.g. add r2, r3
  *  REG_MEM: e.g. add r2, 4(r3 + r4)
  *  MEM_REG: e.g. add 4(r3 + r4), r2
+ *
+ * The memory operand is loaded into a local, operated on like a register and
+ * stored back if it is the destination.
  */
 void
 executeRTypeInstructions(struct instruction_attr* instr_attr_ptr) {
     char *command = instr_attr_ptr->instruction;
-    int *address[2];
+    SIZE_TYPE *address[2];
 
     // Find parameters based on specific format reg-reg/reg-mem/mem-reg.
+    SIZE_TYPE memory_address;
+    SIZE_TYPE memory_operand;
     switch(instr_attr_ptr->format) {
         default:
             printf("ERROR: Unsupported instruction format for R-Type instructions.\n");
@@ -1148,12 +1738,15 @@ executeRTypeInstructions(struct instruction_attr* instr_attr_ptr) {
             address[1] = &GPRS[instr_attr_ptr->base_register];
             break;
         case REG_MEM:
+            memory_address = computeMemoryOperandAddress(instr_attr_ptr);
+            memory_operand = loadMemoryWord(memory_address);
             address[0] = &GPRS[instr_attr_ptr->operand_register];
-            address[1] = (SIZE_TYPE*) &MEMORY[computeMemoryAddressFromOpcode(instr_attr_ptr)];
+            address[1] = &memory_operand;
             break;
         case MEM_REG:
+            memory_operand = loadMemoryWord(computeMemoryOperandAddress(instr_attr_ptr));
             address[1] = &GPRS[instr_attr_ptr->operand_register];
-            address[0] = (SIZE_TYPE *) &MEMORY[computeMemoryAddressFromOpcode(instr_attr_ptr)];
+            address[0] = &memory_operand;
             break;
     }
 
@@ -1213,6 +1806,61 @@ executeRTypeInstructions(struct instruction_attr* instr_attr_ptr) {
     if(strcmp(command, SRA) == 0) {
 	    executeSRA(address[0], address[1]);
     }
+    // CMP command
+    if (strcmp(command, CMP) == 0) {
+        executeCmp(address[0], address[1]);
+    }
+    // MULT command
+    if (strcmp(command, MULT) == 0) {
+        executeMult(address[0], address[1]);
+    }
+    // MULTU command
+    if (strcmp(command, MULTU) == 0) {
+        executeMultU(address[0], address[1]);
+    }
+    // DIVU command
+    if (strcmp(command, DIVU) == 0) {
+        executeDivU(address[0], address[1]);
+    }
+    // POPCNT command
+    if (strcmp(command, POPCNT) == 0) {
+        executePopcnt(address[0], address[1]);
+    }
+    // CLZ command
+    if (strcmp(command, CLZ) == 0) {
+        executeClz(address[0], address[1]);
+    }
+    // CTZ command
+    if (strcmp(command, CTZ) == 0) {
+        executeCtz(address[0], address[1]);
+    }
+    // BSWAP command
+    if (strcmp(command, BSWAP) == 0) {
+        executeBswap(address[0], address[1]);
+    }
+    // ROL command
+    if (strcmp(command, ROL) == 0) {
+        executeRol(address[0], address[1]);
+    }
+    // ROR command
+    if (strcmp(command, ROR) == 0) {
+        executeRor(address[0], address[1]);
+    }
+    // Packed commands
+    if (IsStringInStringArray(command, PACKED_INSTR, NUM_VALID_PACKED_INSTR)) {
+        executePacked(command, address[0], address[1]);
+    }
+    // TEST command
+    if (strcmp(command, TEST) == 0) {
+        executeTest(address[0], address[1]);
+    }
+
+    // Destination was memory, store the result and let the debugger see the
+    // write.
+    if (instr_attr_ptr->format == REG_MEM && strcmp(command, CMP) != 0 && strcmp(command, TEST) != 0) {
+        storeMemoryWord(memory_address, memory_operand);
+        notifyMemoryWrite(memory_address, NUM_BYTES_IN_WORD);
+    }
 }
 
 /*
@@ -1227,6 +1875,8 @@ executeITypeInstructions(struct instruction_attr* instr_attr_ptr) {
     SIZE_TYPE constant = instr_attr_ptr->const_or_label;
 
     SIZE_TYPE *p;
+    SIZE_TYPE memory_address;
+    SIZE_TYPE memory_operand;
     int reg_index;
     switch(instr_attr_ptr->format) {
          default:
@@ -1237,7 +1887,9 @@ executeITypeInstructions(struct instruction_attr* instr_attr_ptr) {
             p = &GPRS[reg_index];
             break;
         case IMM_MEM:
-            p = (SIZE_TYPE *) &MEMORY[computeMemoryAddressFromOpcode(instr_attr_ptr)];
+            memory_address = computeMemoryOperandAddress(instr_attr_ptr);
+            memory_operand = loadMemoryWord(memory_address);
+            p = &memory_operand;
             break;
     }
 
@@ -1262,7 +1914,7 @@ executeITypeInstructions(struct instruction_attr* instr_attr_ptr) {
         executeModI(constant, p);
      }
     // ANDI Command
-    if (strcmp(command, AND) == 0) {
+    if (strcmp(command, ANDI) == 0) {
 	    executeANDI(constant, p);
     }
     // ORI Command
@@ -1293,6 +1945,29 @@ executeITypeInstructions(struct instruction_attr* instr_attr_ptr) {
     if(strcmp(command, SRAI) == 0) {
     	executeSRAI(constant, p);
     }
+    // ROLI command
+    if (strcmp(command, ROLI) == 0) {
+        executeRolI(constant, p);
+    }
+    // RORI command
+    if (strcmp(command, RORI) == 0) {
+        executeRorI(constant, p);
+    }
+    // CMPI command
+    if (strcmp(command, CMPI) == 0) {
+        executeCmpI(constant, p);
+    }
+    // TESTI command
+    if (strcmp(command, TESTI) == 0) {
+        executeTestI(constant, p);
+    }
+
+    // Destination was memory, store the result and let the debugger see the
+    // write.
+    if (instr_attr_ptr->format == IMM_MEM && strcmp(command, CMPI) != 0 && strcmp(command, TESTI) != 0) {
+        storeMemoryWord(memory_address, memory_operand);
+        notifyMemoryWrite(memory_address, NUM_BYTES_IN_WORD);
+    }
 }
 
 /*
@@ -1372,6 +2047,11 @@ executeControlTransferInstructions(struct instruction_attr *instr_attr_ptr) {
     if (strcmp(command, JLE) == 0) {
         executeJLE(label_offset);
     }
+
+    // LOOP command
+    if (strcmp(command, LOOP) == 0) {
+        executeLoop(instr_attr_ptr->operand_register, label_offset);
+    }
 }
 
 /*
@@ -1394,6 +2074,116 @@ executeMovInstructions(struct instruction_attr *instr_attr_ptr) {
         address[0] = &GPRS[instr_attr_ptr->operand_register];
         executeMovI(instr_attr_ptr->const_or_label, address[0]);
     }
+
+    // CMOVcc commands, the condition is the function field of the instruction.
+    if (IsStringInStringArray(command, CMOV_INSTR, NUM_VALID_CMOV_INSTR)) {
+        address[0] = &GPRS[instr_attr_ptr->base_register];
+        address[1] = &GPRS[instr_attr_ptr->operand_register];
+        executeCMov(getFunctFromInstruction(command), address[0], address[1]);
+    }
+
+    // LUI command
+    if (strcmp(command, LUI) == 0) {
+        address[0] = &GPRS[instr_attr_ptr->operand_register];
+        executeLUI(instr_attr_ptr->const_or_label, address[0]);
+    }
+}
+
+/*
+ * Function to execute HI/LO move instructions. Supported format:
+ *  HILO_REG: e.g. mfhi r1
+ */
+void
+executeHiLoInstructions(struct instruction_attr *instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    SIZE_TYPE *reg = &GPRS[instr_attr_ptr->operand_register];
+
+    // MFHI command
+    if (strcmp(command, MFHI) == 0) {
+        executeMfhi(reg);
+    }
+
+    // MFLO command
+    if (strcmp(command, MFLO) == 0) {
+        executeMflo(reg);
+    }
+}
+
+/*
+ * Function to execute block memory instructions. Supported format:
+ *  BLOCK_REG: e.g. memcpy r1, r2, r3 (src/value, dest, count)
+ */
+void
+executeBlockInstructions(struct instruction_attr *instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    SIZE_TYPE *src = &GPRS[instr_attr_ptr->operand_register];
+    SIZE_TYPE *dest = &GPRS[instr_attr_ptr->base_register];
+    SIZE_TYPE *count = &GPRS[instr_attr_ptr->index_register];
+
+    // MEMCPY command
+    if (strcmp(command, MEMCPY) == 0) {
+        executeMemcpy(src, dest, count);
+    }
+
+    // MEMSET command
+    if (strcmp(command, MEMSET) == 0) {
+        executeMemset(src, dest, count);
+    }
+}
+
+/*
+ * Function to execute floating point instructions. Supported format:
+ *  FP_REG_REG: e.g. fadd.d f1, f2
+ *  FP_REG_REG: e.g. fcvt.d.w r1, f2
+ */
+void
+executeFloatInstructions(struct instruction_attr *instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    int src = instr_attr_ptr->operand_register;
+    int dest = instr_attr_ptr->base_register;
+
+    // FADD.S/FADD.D commands
+    if (strcmp(command, FADDS) == 0 || strcmp(command, FADDD) == 0) {
+        executeFloat(FP_ADD, strcmp(command, FADDS) == 0, &FPRS[src], &FPRS[dest]);
+    }
+    // FSUB.S/FSUB.D commands
+    else if (strcmp(command, FSUBS) == 0 || strcmp(command, FSUBD) == 0) {
+        executeFloat(FP_SUB, strcmp(command, FSUBS) == 0, &FPRS[src], &FPRS[dest]);
+    }
+    // FMUL.S/FMUL.D commands
+    else if (strcmp(command, FMULS) == 0 || strcmp(command, FMULD) == 0) {
+        executeFloat(FP_MUL, strcmp(command, FMULS) == 0, &FPRS[src], &FPRS[dest]);
+    }
+    // FDIV.S/FDIV.D commands
+    else if (strcmp(command, FDIVS) == 0 || strcmp(command, FDIVD) == 0) {
+        executeFloat(FP_DIV, strcmp(command, FDIVS) == 0, &FPRS[src], &FPRS[dest]);
+    }
+    // FSQRT.S/FSQRT.D commands
+    else if (strcmp(command, FSQRTS) == 0 || strcmp(command, FSQRTD) == 0) {
+        executeFloat(FP_SQRT, strcmp(command, FSQRTS) == 0, &FPRS[src], &FPRS[dest]);
+    }
+    // FCMP.S/FCMP.D commands
+    else if (strcmp(command, FCMPS) == 0 || strcmp(command, FCMPD) == 0) {
+        executeFCmp(strcmp(command, FCMPS) == 0, &FPRS[src], &FPRS[dest]);
+    }
+    // Integer to floating point conversion
+    else if (strcmp(command, FCVTSW) == 0) {
+        FPRS[dest] = roundToSingle((SIGNED_SIZE_TYPE) GPRS[src]);
+    } else if (strcmp(command, FCVTDW) == 0) {
+        FPRS[dest] = (double) (SIGNED_SIZE_TYPE) GPRS[src];
+    }
+    // Floating point to integer conversion, rounding towards zero
+    else if (strcmp(command, FCVTWS) == 0) {
+        GPRS[dest] = floatToInteger(roundToSingle(FPRS[src]));
+    } else if (strcmp(command, FCVTWD) == 0) {
+        GPRS[dest] = floatToInteger(FPRS[src]);
+    }
+    // Precision conversion
+    else if (strcmp(command, FCVTSD) == 0) {
+        FPRS[dest] = roundToSingle(FPRS[src]);
+    } else if (strcmp(command, FCVTDS) == 0) {
+        FPRS[dest] = FPRS[src];
+    }
 }
 
 /*
@@ -1410,65 +2200,123 @@ executeNoOperandInstructions(struct instruction_attr *instr_attr_ptr) {
 }
 
 /*
- * Function to decode the instructions from the instruction memory and execute.
- */
-void
-decodeAndExecuteInstructions() {
-   SIZE_TYPE binary_opcode = readFromMemory(PC, NUM_BYTES_IN_WORD);
-   PC = PC + 4;
-   int instr_count = 1;
-
-   while (binary_opcode != 0) {
-       struct instruction_attr instr_attr;
-       printf("Instruction Count: %d\t Executing opcode: 0x%x", instr_count, binary_opcode);
-       isSubtract = false;
-       decodeInstructionFromBinary(binary_opcode, &instr_attr);
-
-       printf("\t Assembly Instruction: %s\n", instr_attr.instruction);
-       
-       // Call functions to execute instructions based on instruction format.
-       switch(instr_attr.format) {
-           default:
-               printf("ERROR: Unsupported instruction format.\n");
-               exit(0);
-               break;
-           case LOAD_STORE:
-               executeMemoryTypeInstructions(&instr_attr);
-               break;
-           case REG_REG:
-           case REG_MEM:
-           case MEM_REG:
-               executeRTypeInstructions(&instr_attr);
-               break;
-           case IMM_REG:
-           case IMM_MEM:
-               executeITypeInstructions(&instr_attr);
-               break;
-    	   case STACK_REG:
-               executeStackInstructions(&instr_attr);
-               break;
-           case MEM_DISPLAY:
-               executeMemoryDisplayInstructions(&instr_attr);
-               break;
-           case CONTROL_LABEL:
-               executeControlTransferInstructions(&instr_attr);
-               break;
-           case MOV_IMM_REG:
-           case MOV_REG_REG:
-               executeMovInstructions(&instr_attr);
-               break;
-           case NO_OPERAND:
-               executeNoOperandInstructions(&instr_attr);
-               break;
-       }
-       displayRegisters();
-       PRINT_CHAR('=', 85);NEWLINE(1);
-       PRINT_CHAR('=', 85); NEWLINE(2);
-       // Read the next instruction and increment the PC
-       binary_opcode = readFromMemory(PC, NUM_BYTES_IN_WORD);
-       PC = PC + 4;
-       instr_count++;
-   }
+ * Function to execute a decoded instruction based on its instruction format.
+ */
+static inline void
+executeInstruction(struct instruction_attr *instr_attr_ptr) {
+    switch(instr_attr_ptr->format) {
+        default:
+            printf("ERROR: Unsupported instruction format.\n");
+            exit(0);
+            break;
+        case LOAD_STORE:
+            executeMemoryTypeInstructions(instr_attr_ptr);
+            break;
+        case REG_REG:
+        case REG_MEM:
+        case MEM_REG:
+            executeRTypeInstructions(instr_attr_ptr);
+            break;
+        case IMM_REG:
+        case IMM_MEM:
+            executeITypeInstructions(instr_attr_ptr);
+            break;
+        case STACK_REG:
+            executeStackInstructions(instr_attr_ptr);
+            break;
+        case MEM_DISPLAY:
+            executeMemoryDisplayInstructions(instr_attr_ptr);
+            break;
+        case CONTROL_LABEL:
+            executeControlTransferInstructions(instr_attr_ptr);
+            break;
+        case MOV_IMM_REG:
+        case MOV_REG_REG:
+            executeMovInstructions(instr_attr_ptr);
+            break;
+        case NO_OPERAND:
+            executeNoOperandInstructions(instr_attr_ptr);
+            break;
+        case BLOCK_REG:
+            executeBlockInstructions(instr_attr_ptr);
+            break;
+        case HILO_REG:
+            executeHiLoInstructions(instr_attr_ptr);
+            break;
+        case FP_REG_REG:
+            executeFloatInstructions(instr_attr_ptr);
+            break;
+    }
+}
+
+/*
+ * Function to verify that the PC points into the assembled instructions (or at
+ * the end of them, which stops execution) and the SP into the stack memory.
+ * Used by the checked interpreter variant.
+ */
+void
+checkValidExecutionState() {
+    if (PC < INSTRUCTION_MEMORY_MIN || PC > INSTR_MEMORY_PTR
+            || (PC - INSTRUCTION_MEMORY_MIN) % INSTR_SIZE != 0) {
+        printf("ERROR: Invalid PC '%" PRIuW "'. The PC falls outside the assembled instructions.\n", PC);
+        exit(0);
+    }
+    if (SP <= DATA_MEMORY_MAX || SP >= MEMORY_SIZE) {
+        printf("ERROR: Invalid SP '%" PRIuW "'. The SP falls outside the stack memory.\n", SP);
+        exit(0);
+    }
+}
+
+#include "cpu_hotloop.c"
+
+// Generate the interpreter variants from the common decode and execute loop.
+#define INTERP_NAME     decodeAndExecuteInstructionsFast
+#define INTERP_TRACE    0
+#define INTERP_CHECK    0
+#define INTERP_PROFILE  0
+#define INTERP_HOT_LOOPS 1
+#include "cpu_interpreter.c"
+
+#define INTERP_NAME     decodeAndExecuteInstructionsChecked
+#define INTERP_TRACE    0
+#define INTERP_CHECK    1
+#define INTERP_PROFILE  0
+#define INTERP_HOT_LOOPS 0
+#include "cpu_interpreter.c"
+
+#define INTERP_NAME     decodeAndExecuteInstructionsTraced
+#define INTERP_TRACE    1
+#define INTERP_CHECK    0
+#define INTERP_PROFILE  0
+#define INTERP_HOT_LOOPS 0
+#include "cpu_interpreter.c"
+
+#define INTERP_NAME     decodeAndExecuteInstructionsProfiled
+#define INTERP_TRACE    0
+#define INTERP_CHECK    0
+#define INTERP_PROFILE  1
+#define INTERP_HOT_LOOPS 0
+#include "cpu_interpreter.c"
+
+/*
+ * Function to decode the instructions from the instruction memory and execute
+ * them with the given interpreter variant.
+ *
+ * Returns the number of executed instructions.
+ */
+long
+decodeAndExecuteInstructions(interpreter_variants variant) {
+    switch (variant) {
+        case INTERP_FAST:
+            return decodeAndExecuteInstructionsFast();
+        case INTERP_CHECKED:
+            return decodeAndExecuteInstructionsChecked();
+        case INTERP_PROFILED:
+            return decodeAndExecuteInstructionsProfiled();
+        case INTERP_TRACED:
+        default:
+            return decodeAndExecuteInstructionsTraced();
+    }
 }
 
 
@@ -1484,6 +2332,14 @@ isValidRegister(char *reg) {
     return IsStringInStringArray(reg, valid_registers, NUM_VALID_REGISTERS);
 }
 
+/*
+ * Returns true if given reg name is a valid floating point register name.
+ */
+bool
+isValidFloatRegister(char *reg) {
+    return IsStringInStringArray(reg, valid_float_registers, NUM_VALID_FLOAT_REGISTERS);
+}
+
 /*
  * Print generic error.
  */
@@ -1631,7 +2487,7 @@ getValidMemoryAddress(char* arg, struct instruction_attr *instr_attr_ptr) {
 void
 checkValidMemoryAccess(SIZE_TYPE memory_address) {
     if (memory_address >= MEMORY_SIZE || memory_address < INSTRUCTION_MEMORY_MAX) {
-        printf("ERROR: Invalid Memory Address Access '%u'. The address falls in bootstrap/instruction memory range.\n", memory_address);
+        printf("ERROR: Invalid Memory Address Access '%" PRIuW "'. The address falls in bootstrap/instruction memory range.\n", memory_address);
         exit(0);
     } 
 }
@@ -1646,7 +2502,24 @@ getConstant(char* arg) {
                 arg);
         exit(0);
     }
-    return getLongFromBaseTenOrHexString(&arg[1]);
+    return getLongFromBaseTenOrHexString(&arg[1]);
+}
+
+/*
+ * Returns true if the immediate constant of the given instruction does not fit
+ * in its instruction encoding and has to be stored in an extension word.
+ * MOVI encodes 16 bits and the Immediate-Type instructions encode 8 bits, both
+ * sign extended.
+ */
+bool
+isWideImmediate(char *command, SIZE_TYPE constant) {
+    if (strcmp(command, MOVI) == 0) {
+        return (SIZE_TYPE) (short) constant != constant;
+    }
+    if (IsStringInStringArray(command, I_INSTR, NUM_VALID_I_INSTR)) {
+        return (SIZE_TYPE) (signed char) constant != constant;
+    }
+    return false;
 }
 
 /*
@@ -1655,8 +2528,14 @@ getConstant(char* arg) {
  */
 void 
 validateMemoryTypeInstruction(char* command, char* arg1, char* arg2) {
-    // First argument should be a register only.
-    if (!isValidRegister(arg1)) {
+    // First argument should be a register only, a floating point register for
+    // the floating point load/store.
+    if (IsStringInStringArray(command, FP_MEM_INSTR, NUM_VALID_FP_MEM_INSTR)) {
+        if (!isValidFloatRegister(arg1)) {
+            printf("ERROR: arg1 should be a valid floating point register.\n");
+            exit(0);
+        }
+    } else if (!isValidRegister(arg1)) {
         printf("ERROR: arg1 should be a valid register.\n");
         exit(0);
     }
@@ -1671,6 +2550,14 @@ validateMemoryTypeInstruction(char* command, char* arg1, char* arg2) {
 
     int reg = (int)strtol(&arg1[1], NULL, 10);
 
+    // Vector load/store use VECTOR_REGS consecutive registers.
+    if ((strcmp(command, VLOAD) == 0 || strcmp(command, VSTORE) == 0)
+            && reg + VECTOR_REGS > MAX_GPRS) {
+        printf("ERROR: %s needs %d consecutive registers starting at arg1, up to r%d.\n",
+                command, VECTOR_REGS, MAX_GPRS - 1);
+        exit(0);
+    }
+
     // Set the remaining instruction attributes.
     instr_attr.format = LOAD_STORE;
     instr_attr.operand_register = reg;
@@ -1717,6 +2604,10 @@ validateRTypeInstruction(char* command, char** args, int arg_count) {
         instr_attr.format = REG_REG;
         instr_attr.operand_register = reg_array[0];
         instr_attr.base_register = reg_array[1];
+    } else if (isFunctOpcode(getOpcodeFromInstruction(command))) {
+        // The function field shares the bits of the memory offset.
+        printf("ERROR: '%s' instruction supports register arguments only.\n", command);
+        exit(0);
     } else if (reg_index < mem_index) {
         // Case of reg-mem format i.e. instr src_reg, dest_mem
         instr_attr.format = REG_MEM;
@@ -1732,6 +2623,64 @@ validateRTypeInstruction(char* command, char** args, int arg_count) {
     saveInstructionToMemory(binary_opcode);
 }
 
+/*
+ * Function to validate packed instructions. Only the register-register format
+ * is supported since the function field shares the memory offset bits.
+ * Valid syntax:
+ *      PADD.B src_reg, dest_reg
+ */
+void
+validatePackedInstruction(char* command, char* arg1, char* arg2) {
+    struct instruction_attr instr_attr;
+    if (!isValidRegister(arg1) || !isValidRegister(arg2)) {
+        printf("ERROR: '%s' instruction needs two General Purpose register arguments.\n", command);
+        exit(0);
+    }
+
+    strcpy(instr_attr.instruction, command);
+    instr_attr.format = REG_REG;
+    instr_attr.operand_register = (int)strtol(&arg1[1], NULL, 10);
+    instr_attr.base_register = (int)strtol(&arg2[1], NULL, 10);
+
+    SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
+    saveInstructionToMemory(binary_opcode);
+}
+
+/*
+ * Function to validate floating point instructions. Only the register-register
+ * format is supported. The conversions from/to integer take a General Purpose
+ * register as the source/destination respectively.
+ * Valid syntax:
+ *      FADD.D src_freg, dest_freg
+ *      FCVT.D.W src_reg, dest_freg
+ *      FCVT.W.D src_freg, dest_reg
+ */
+void
+validateFloatInstruction(char* command, char* arg1, char* arg2) {
+    struct instruction_attr instr_attr;
+    bool is_src_int = IsStringInStringArray(command, FP_FROM_INT_INSTR, NUM_VALID_FP_FROM_INT_INSTR);
+    bool is_dest_int = IsStringInStringArray(command, FP_TO_INT_INSTR, NUM_VALID_FP_TO_INT_INSTR);
+
+    if (is_src_int ? !isValidRegister(arg1) : !isValidFloatRegister(arg1)) {
+        printf("ERROR: arg1 of '%s' should be a valid %s register.\n", command,
+                is_src_int ? "General Purpose" : "floating point");
+        exit(0);
+    }
+    if (is_dest_int ? !isValidRegister(arg2) : !isValidFloatRegister(arg2)) {
+        printf("ERROR: arg2 of '%s' should be a valid %s register.\n", command,
+                is_dest_int ? "General Purpose" : "floating point");
+        exit(0);
+    }
+
+    strcpy(instr_attr.instruction, command);
+    instr_attr.format = FP_REG_REG;
+    instr_attr.operand_register = (int)strtol(&arg1[1], NULL, 10);
+    instr_attr.base_register = (int)strtol(&arg2[1], NULL, 10);
+
+    SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
+    saveInstructionToMemory(binary_opcode);
+}
+
 /*
  * Function to execute all stack instructions after performing appropriate
  * validations on the arguments passed.
@@ -1784,11 +2733,19 @@ validateITypeInstruction(char* command, char* arg1, char* arg2) {
 
     // Set instruction attributes
     strcpy(instr_attr.instruction, command);
-    instr_attr.const_or_label = (int) constant;
+    instr_attr.const_or_label = (SIGNED_SIZE_TYPE) constant;
+    instr_attr.is_extended = isWideImmediate(command, constant);
 
     if (is_imm_reg) {
         instr_attr.format = IMM_REG;
         instr_attr.operand_register = reg_index;    
+    } else if (instr_attr.is_extended) {
+        printf("ERROR: Constant '%s' does not fit in 8 bits. Wide constants are only supported with a register operand.\n", arg1);
+        exit(0);
+    } else if (isFunctOpcode(getOpcodeFromInstruction(command))) {
+        // The function field shares the bits of the memory offset.
+        printf("ERROR: '%s' instruction supports a register argument only.\n", command);
+        exit(0);
     } else {
         instr_attr.format = IMM_MEM;
     }
@@ -1796,6 +2753,11 @@ validateITypeInstruction(char* command, char* arg1, char* arg2) {
     // Call function to encode the instruction to binary
     SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
     saveInstructionToMemory(binary_opcode);
+
+    // Save the wide constant in the extension word.
+    if (instr_attr.is_extended) {
+        saveExtensionWordToMemory(constant);
+    }
 }
 
 /*
@@ -1820,36 +2782,102 @@ validateMemoryDisplayInstruction(char *command, char* arg1, char* arg2) {
 
     // Set instruction attributes
     strcpy(instr_attr.instruction, command);
-    instr_attr.const_or_label = (int) constant;
+    instr_attr.const_or_label = (SIGNED_SIZE_TYPE) constant;
     instr_attr.format = IMM_REG;
     instr_attr.operand_register = reg_index;    
+    instr_attr.is_extended = false;
 
     // Call function to encode the instruction to binary
     SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
     saveInstructionToMemory(binary_opcode);
 }
 
+/*
+ * Function to record that the control transfer instruction at the given
+ * instruction memory position refers to a label which is not defined yet.
+ */
+void
+storeLabelFixup(char* label, int position) {
+    if (strlen(label) >= sizeof(FIXUPS[0].label)) {
+        printf("Label '%s' is longer than %d characters.\n", label, (int) sizeof(FIXUPS[0].label) - 1);
+        exit(0);
+    }
+    if (FIXUP_COUNT == TOTAL_INSTRUCTION_SLOTS) {
+        printf("ERROR: Too many references to undefined labels. At most %d are supported.\n",
+                TOTAL_INSTRUCTION_SLOTS);
+        exit(0);
+    }
+    strcpy(FIXUPS[FIXUP_COUNT].label, label);
+    FIXUPS[FIXUP_COUNT].position = position;
+    FIXUP_COUNT++;
+}
+
+/*
+ * Function to patch the label offset of every instruction waiting for the given
+ * label, which has just been defined at label_position, and drop their fixups.
+ */
+void
+resolveLabelFixups(char* label, int label_position) {
+    int i = 0;
+    while (i < FIXUP_COUNT) {
+        if (strcmp(label, FIXUPS[i].label) != 0) {
+            ++i;
+            continue;
+        }
+        // The label offset is held in the low 16 bits of CONTROL_LABEL.
+        SIZE_TYPE address = INSTRUCTION_MEMORY_MIN + FIXUPS[i].position * INSTR_SIZE;
+        uint32_t instruction = (uint32_t) readFromMemory(address, INSTR_SIZE);
+        int label_offset = label_position - FIXUPS[i].position - 1;
+        instruction = (instruction & ~0xffffu) | (label_offset & 0xffff);
+        writeIntoMemory(address, INSTR_SIZE, (data_ptr) &instruction);
+
+        FIXUPS[i] = FIXUPS[--FIXUP_COUNT];
+    }
+}
+
 /*
  * Function to validate a control-transfer type instruction such as
  * jmp/call. Valid syntax is:
  *      jmp label
  *      call label
  *      je label
+ *      loop reg, label
  */
 void
-validateControlTransferInstruction(int instr_number, char *command, char *label_arg) {
+validateControlTransferInstruction(int instr_number, char *command, char **args, int arg_count) {
     struct instruction_attr instr_attr;
+    char *label_arg = args[arg_count - 1];
+    int reg_index = 0;
+
+    // LOOP takes the counter register before the label.
+    if (strcmp(command, LOOP) == 0) {
+        if (arg_count != 2 || !isValidRegister(args[0])) {
+            printf("ERROR: %s should have 2 arguments i.e. register and label.\n", command);
+            exit(0);
+        }
+        reg_index = (int)strtol(&args[0][1], NULL, 10);
+    } else if (arg_count != 1) {
+        printf("ERROR: %s should have only 1 argument i.e. label.\n", command);
+        exit(0);
+    }
    
-    // Validate the argument should be a valid label.
+    // Labels defined further down are not known yet. Save the instruction with
+    // a zero offset and patch it once the label is defined.
     int label_index = getLabelIndex(label_arg);
-    if (label_index == -1) {
+    int label_offset = 0;
+    if (label_index != -1) {
+        label_offset = LABELS[label_index].position - instr_number - 1;
+    } else if (!ALL_LABELS_KNOWN) {
+        storeLabelFixup(label_arg, instr_number);
+    } else {
         printf("ERROR: Invalid label '%s' passed; does not match with any provided labels.\n", label_arg);
         exit(0);
     }
 
     // Set instruction attributes
     strcpy(instr_attr.instruction, command);
-    instr_attr.const_or_label = (int) (LABELS[label_index].position - instr_number - 1);
+    instr_attr.const_or_label = (SIGNED_SIZE_TYPE) label_offset;
+    instr_attr.operand_register = reg_index;
     instr_attr.format = CONTROL_LABEL;
 
     // Call function to encode the instruction to binary
@@ -1862,6 +2890,8 @@ validateControlTransferInstruction(int instr_number, char *command, char *label_
  * Valid syntax:
  *      MOV reg, reg
  *      MOVI constant, reg
+ *      LUI constant, reg
+ *      CMOVcc reg, reg
  */
 void
 validateMovTypeInstruction(char *command, char *arg1, char *arg2) {
@@ -1896,17 +2926,91 @@ validateMovTypeInstruction(char *command, char *arg1, char *arg2) {
     // Set instruction attributes
     strcpy(instr_attr.instruction, command);
     instr_attr.operand_register = dest_reg_index;    
+    instr_attr.is_extended = false;
     if (is_mov_imm) {
-        instr_attr.const_or_label = (int) constant;
+        instr_attr.const_or_label = (SIGNED_SIZE_TYPE) constant;
         instr_attr.format = MOV_IMM_REG;
+        instr_attr.is_extended = isWideImmediate(command, constant);
     } else {
         instr_attr.base_register = src_reg_index;
         instr_attr.format = MOV_REG_REG;
     }
+
+    // Conditional moves are register to register only.
+    if (is_mov_imm && IsStringInStringArray(command, CMOV_INSTR, NUM_VALID_CMOV_INSTR)) {
+        printf("ERROR: %s expects two register arguments.\n", command);
+        exit(0);
+    }
+
+    // LUI only takes the 16 bit upper half.
+    if (strcmp(command, LUI) == 0 && (!is_mov_imm || constant > 0xffff)) {
+        printf("ERROR: %s expects a 16 bit constant in range [0, 0xffff].\n", command);
+        exit(0);
+    }
     
     // Call function to encode the instruction to binary
     SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
     saveInstructionToMemory(binary_opcode);
+
+    // Save the wide constant in the extension word.
+    if (instr_attr.is_extended) {
+        saveExtensionWordToMemory(constant);
+    }
+}
+
+/*
+ * Function to validate HI/LO move instructions.
+ * Valid syntax:
+ *      MFHI reg
+ *      MFLO reg
+ */
+void
+validateHiLoInstruction(char *command, char *arg1) {
+    struct instruction_attr instr_attr;
+    if (!isValidRegister(arg1)) {
+        printf("ERROR: '%s' instruction needs a valid General Purpose register argument only. "
+                "Invalid register argument passed '%s'.\n", command, arg1);
+        exit(0);
+    }
+
+    strcpy(instr_attr.instruction, command);
+    instr_attr.format = HILO_REG;
+    instr_attr.operand_register = (int)strtol(&arg1[1], NULL, 10);
+
+    SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
+    saveInstructionToMemory(binary_opcode);
+}
+
+/*
+ * Function to validate block memory instructions.
+ * Valid syntax:
+ *      MEMCPY src_reg, dest_reg, count_reg
+ *      MEMSET value_reg, dest_reg, count_reg
+ */
+void
+validateBlockInstruction(char *command, char **args) {
+    struct instruction_attr instr_attr;
+    int reg_index[3];
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        if (!isValidRegister(args[i])) {
+            printf("ERROR: '%s' instruction needs General Purpose register arguments only. "
+                    "Invalid register argument passed '%s'.\n", command, args[i]);
+            exit(0);
+        }
+        reg_index[i] = (int)strtol(&args[i][1], NULL, 10);
+    }
+
+    // Set instruction attributes
+    strcpy(instr_attr.instruction, command);
+    instr_attr.format = BLOCK_REG;
+    instr_attr.operand_register = reg_index[0];
+    instr_attr.base_register = reg_index[1];
+    instr_attr.index_register = reg_index[2];
+
+    SIZE_TYPE binary_opcode = encodeInstructionToBinary(&instr_attr);
+    saveInstructionToMemory(binary_opcode);
 }
 
 /*
@@ -1928,7 +3032,6 @@ validateNoOperandInstruction(char *command) {
  */
 void 
 validateEncodeAndSaveInstruction(int instr_number, char* command, char** args, int arg_count) {
-    removeWhiteSpaces(args, arg_count);
     // Memory-Type instructions
     if (IsStringInStringArray(command, MEM_INSTR, NUM_VALID_MEM_INSTR)) {
         if (arg_count != 2) {
@@ -1971,11 +3074,11 @@ validateEncodeAndSaveInstruction(int instr_number, char* command, char** args, i
     }
     // Control transfer type instructions e.g. jmp, call
     else if (IsStringInStringArray(command, CONTROL_INSTR, NUM_VALID_CONTROL_INSTR)) {
-        if (arg_count != 1) {
-            printf("ERROR: %s should have only 1 argument i.e. label.\n", command);
+        if (arg_count < 1) {
+            printf("ERROR: %s should have a label argument.\n", command);
             exit(0);
         }
-        validateControlTransferInstruction(instr_number, command, args[0]);
+        validateControlTransferInstruction(instr_number, command, args, arg_count);
     }
     // Mov data instructions
     else if (IsStringInStringArray(command, MOV_INSTR, NUM_VALID_MOV_INSTR)) {
@@ -1985,6 +3088,38 @@ validateEncodeAndSaveInstruction(int instr_number, char* command, char** args, i
         }
         validateMovTypeInstruction(command, args[0], args[1]);
     }
+    // Packed instructions
+    else if (IsStringInStringArray(command, PACKED_INSTR, NUM_VALID_PACKED_INSTR)) {
+        if (arg_count != 2) {
+            printf("ERROR: %s should have 2 arguments.\n", command);
+            exit(0);
+        }
+        validatePackedInstruction(command, args[0], args[1]);
+    }
+    // Floating point instructions
+    else if (IsStringInStringArray(command, FP_INSTR, NUM_VALID_FP_INSTR)) {
+        if (arg_count != 2) {
+            printf("ERROR: %s should have 2 arguments.\n", command);
+            exit(0);
+        }
+        validateFloatInstruction(command, args[0], args[1]);
+    }
+    // HI/LO move instructions
+    else if (IsStringInStringArray(command, HILO_INSTR, NUM_VALID_HILO_INSTR)) {
+        if (arg_count != 1) {
+            printf("ERROR: %s should have only 1 argument i.e. a register.\n", command);
+            exit(0);
+        }
+        validateHiLoInstruction(command, args[0]);
+    }
+    // Block memory instructions
+    else if (IsStringInStringArray(command, BLOCK_INSTR, NUM_VALID_BLOCK_INSTR)) {
+        if (arg_count != 3) {
+            printf("ERROR: %s should have 3 arguments.\n", command);
+            exit(0);
+        }
+        validateBlockInstruction(command, args);
+    }
     // No operand instructions
     else if (IsStringInStringArray(command, NO_OPERAND_INSTR, NUM_VALID_NO_OPERAND_INSTR)) {
         if (arg_count != 0) {
@@ -2034,118 +3169,444 @@ initializeRegistersAndMemory() {
 }
 
 /*
- * Main function to start application.
-*/
-int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        printf("Correct usage is <binary_name> <file_name>");
+ * Function to copy a label token into label, which must be the size of the
+ * labels in LABELS.
+ */
+void
+getLabelFromToken(struct token label_token, char *label) {
+    if (!copyTokenWithoutSpaces(label_token, label, sizeof(LABELS[0].label))) {
+        printf("Label '%.*s' is longer than %d characters.\n", label_token.length,
+                label_token.start, (int) sizeof(LABELS[0].label) - 1);
+        exit(0);
     }
-    initializeRegistersAndMemory();
+}
 
-    // Read and execute assembly instructions from input file.
-    char *input = NULL;
-    size_t len = 0;
-    ssize_t read;
-    int instr_count = 1;
-    
-    // Read instructions file.
-    FILE *fp;
+/*
+ * Function to define the label at the given instruction memory position.
+ */
+void
+defineLabel(char *label, int instr_position) {
+    if (storeLabelInformation(label, instr_position) == -1) {
+        printf("Label '%s' defined multiple times.\n", label);
+        exit(0);
+    }
+}
 
-    // First scan of the program for finding out positions of the labels.
-    fp = fopen(argv[1], "r");
-    if (fp == NULL) {
-        printf("ERROR: File not available to read. \n");
-        exit(EXIT_FAILURE);
+/*
+ * Function to validate, encode and save one source line at the given
+ * instruction memory position. The label of the line, if any, is defined first
+ * unless define_label is false i.e. the labels were already collected.
+ */
+void
+assembleSourceLine(struct token line, int line_number, int instr_position, bool define_label) {
+    struct token label_token, command_token, operand_tokens[MAX_OPERANDS];
+    int arg_count = tokenizeInstructionLine(line, &label_token, &command_token, operand_tokens);
+
+    // Define the label(if any).
+    if (define_label && label_token.length != 0) {
+        char label[sizeof(LABELS[0].label)];
+        getLabelFromToken(label_token, label);
+        defineLabel(label, instr_position);
+        resolveLabelFixups(label, instr_position);
     }
-    
-    int instruction_position = 0;
-    while((read = getline(&input, &len, fp)) != -1) {
-        if (strlen(input) < 3) {
+
+    if (ASSEMBLY_LISTING) {
+        NEWLINE(1);
+        printf("Instruction %d: %.*s\n", line_number,
+                (int) (line.start + line.length - command_token.start), command_token.start);
+    }
+
+    char command[10];
+    if (!copyTokenWithoutSpaces(command_token, command, sizeof(command))
+            || !IsStringInStringArray(command, valid_instructions, NUM_VALID_OPCODES)) {
+      printf("ERROR: Assembly Command '%.*s' not supported.\n", command_token.length,
+              command_token.start);
+      exit(0);
+    }
+    if (arg_count == -1) {
+        printf("ERROR: %s cannot have more than %d arguments.\n", command, MAX_OPERANDS);
+        exit(0);
+    }
+
+    // The validators take the operands as strings.
+    char operands[MAX_OPERANDS][MAX_OPERAND_LENGTH];
+    char *args[MAX_OPERANDS];
+    int i;
+    for (i = 0; i < arg_count; i++) {
+        if (!copyTokenWithoutSpaces(operand_tokens[i], operands[i], MAX_OPERAND_LENGTH)) {
+            printf("ERROR: Argument '%.*s' is too long.\n", operand_tokens[i].length,
+                    operand_tokens[i].start);
+            exit(0);
+        }
+        args[i] = operands[i];
+    }
+    validateEncodeAndSaveInstruction(instr_position, command, args, arg_count);
+}
+
+/*
+ * Returns the number of words the given instruction occupies in instruction
+ * memory i.e. 1 + IMM_EXT_WORDS for instructions with a wide immediate
+ * constant, otherwise 1. Invalid instructions are left to be reported when
+ * they are encoded.
+ */
+int
+getInstructionSizeInWords(struct token command_token, struct token *operand_tokens, int arg_count) {
+    char command[10];
+    char constant[MAX_OPERAND_LENGTH];
+    if (arg_count < 1 || operand_tokens[0].start[0] != '$'
+            || !copyTokenWithoutSpaces(command_token, command, sizeof(command))
+            || !copyTokenWithoutSpaces(operand_tokens[0], constant, sizeof(constant))) {
+        return 1;
+    }
+    return isWideImmediate(command, getConstant(constant)) ? 1 + IMM_EXT_WORDS : 1;
+}
+
+/*
+ * Function to assemble the program in a single pass. Jumps to labels that are
+ * not defined yet are patched when the label is reached.
+ */
+void
+assembleInSinglePass(struct source_buffer *source) {
+    const char *cursor = source->data;
+    const char *source_end = source->data + source->size;
+    struct token line;
+    int line_number = 1;
+
+    while (nextSourceLine(&cursor, source_end, &line)) {
+        trimToken(&line);
+        if (line.length == 0) {
             continue;
         }
 
-        int colon_index = getIndexOfFirstChar(input, ':');
-        int space_index = getIndexOfFirstChar(input, ' ');
-        if (colon_index != -1) {
-            if (space_index != -1 && space_index < colon_index) {
-                continue;
-            }
-            char *label = (char*) malloc(sizeof(char) * (colon_index + 1));
-            snprintf(label, colon_index+1, "%s", input);
-            if (storeLabelInformation(label, instruction_position) == -1) {
-                printf("Label '%s' defined multiple times.\n", label);
-                exit(0);
-            }
-            free(label);
+        // Labels are positioned by instruction memory word, which differs from
+        // the line count once wide constants take an extension word.
+        int instr_position = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+        assembleSourceLine(line, line_number++, instr_position, true);
+        if (INSTR_MEMORY_PTR > INSTRUCTION_MEMORY_MAX + 1) {
+            printf("ERROR: Program does not fit in instruction memory.\n");
+            exit(0);
         }
-        ++instruction_position;
     }
-    rewind(fp);
+}
 
-    PRINT_CHAR('=', 85); NEWLINE(1);
-    PRINT_CHAR('=', 85); NEWLINE(1);
-    printf("VALIDATING and DECODING INSTRUCTIONS\n");
+// Source lines of the program and their instruction memory positions, for the
+// parallel assembler.
+struct source_line {
+    struct token line;
+    int position;
+};
+
+struct source_line SOURCE_LINES[TOTAL_INSTRUCTION_SLOTS];
+int SOURCE_LINE_COUNT = 0;
+
+// Range of SOURCE_LINES assembled by one thread.
+struct assembly_chunk {
+    int first_line;
+    int end_line;
+};
+
+/*
+ * Thread function of the parallel assembler. Encodes its chunk of source lines
+ * straight into their precomputed positions in instruction memory.
+ */
+void *
+assembleSourceChunk(void *arg) {
+    struct assembly_chunk *chunk = (struct assembly_chunk *) arg;
+    SIZE_TYPE assembly_ptr;
+    ASSEMBLY_PTR = &assembly_ptr;
+
+    int i;
+    for (i = chunk->first_line; i < chunk->end_line; i++) {
+        assembly_ptr = INSTRUCTION_MEMORY_MIN + SOURCE_LINES[i].position * INSTR_SIZE;
+        assembleSourceLine(SOURCE_LINES[i].line, i + 1, SOURCE_LINES[i].position, false);
+    }
+
+    // Leave no pointer to this stack frame behind.
+    ASSEMBLY_PTR = &INSTR_MEMORY_PTR;
+    return NULL;
+}
 
-    while ((read = getline(&input, &len, fp)) != -1) {
-        if (strlen(input) < 3) {
+/*
+ * Function to assemble the program using the given number of threads. A first
+ * pass over the source collects the labels and the position of every
+ * instruction, then the lines are split into one chunk per thread and encoded
+ * in parallel. The assembly listing is not printed.
+ */
+void
+assembleInParallel(struct source_buffer *source, int num_threads) {
+    const char *cursor = source->data;
+    const char *source_end = source->data + source->size;
+    struct token line;
+    int instr_position = 0;
+
+    while (nextSourceLine(&cursor, source_end, &line)) {
+        trimToken(&line);
+        if (line.length == 0) {
             continue;
         }
+        if (SOURCE_LINE_COUNT == TOTAL_INSTRUCTION_SLOTS) {
+            printf("ERROR: Program does not fit in instruction memory.\n");
+            exit(0);
+        }
+
+        struct token label_token, command_token, operand_tokens[MAX_OPERANDS];
+        int arg_count = tokenizeInstructionLine(line, &label_token, &command_token, operand_tokens);
+        if (label_token.length != 0) {
+            char label[sizeof(LABELS[0].label)];
+            getLabelFromToken(label_token, label);
+            defineLabel(label, instr_position);
+        }
 
-        // Remove the label(if any) from the instruction
-        int colon_index = getIndexOfFirstChar(input, ':');
-        input = &input[colon_index + 1];
+        SOURCE_LINES[SOURCE_LINE_COUNT].line = line;
+        SOURCE_LINES[SOURCE_LINE_COUNT].position = instr_position;
+        SOURCE_LINE_COUNT++;
+        instr_position += getInstructionSizeInWords(command_token, operand_tokens, arg_count);
+    }
+    if (instr_position > TOTAL_INSTRUCTION_SLOTS) {
+        printf("ERROR: Program does not fit in instruction memory.\n");
+        exit(0);
+    }
+    ALL_LABELS_KNOWN = true;
+    ASSEMBLY_LISTING = false;
 
-        // Remove any leading space from the input
-        while (isspace ((unsigned char) *input)) {
-            input++;
+    if (num_threads > SOURCE_LINE_COUNT) {
+        num_threads = SOURCE_LINE_COUNT > 0 ? SOURCE_LINE_COUNT : 1;
+    }
+    pthread_t threads[MAX_ASSEMBLY_THREADS];
+    struct assembly_chunk chunks[MAX_ASSEMBLY_THREADS];
+    int i;
+    for (i = 0; i < num_threads; i++) {
+        chunks[i].first_line = (long) SOURCE_LINE_COUNT * i / num_threads;
+        chunks[i].end_line = (long) SOURCE_LINE_COUNT * (i + 1) / num_threads;
+        if (pthread_create(&threads[i], NULL, assembleSourceChunk, &chunks[i]) != 0) {
+            printf("ERROR: Could not start assembler thread.\n");
+            exit(EXIT_FAILURE);
         }
+    }
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
 
-        NEWLINE(1);
-        printf("Instruction %d: %s", instr_count++, input);
+    INSTR_MEMORY_PTR = INSTRUCTION_MEMORY_MIN + instr_position * INSTR_SIZE;
+    ASSEMBLY_LISTING = true;
+    printf("Assembled %d instructions using %d threads.\n", SOURCE_LINE_COUNT, num_threads);
+}
+
+// The microbenchmarks include this file for the simulator functions and
+// provide their own main.
+#ifndef CPU_NO_MAIN
+/*
+ * Main function to start application.
+*/
+int main(int argc, char* argv[]) {
+    // Breakpoints/watchpoints requested on the command line. These are
+    // resolved once the labels are known.
+    char *breakpoint_args[TOTAL_INSTRUCTION_SLOTS];
+    char *watchpoint_args[TOTAL_WATCHPOINTS];
+    int breakpoint_arg_count = 0;
+    int watchpoint_arg_count = 0;
+    interpreter_variants variant = INTERP_TRACED;
+    bool display_stats = false;
+    int num_threads = 1;
+    // The assembly cache is used with -C, or when $CPU_CACHE_DIR is set.
+    bool use_cache = isCacheDirectorySet();
+    bool clear_cache = false;
+    char *object_file_name = NULL;
+    bool optimize = false;
+    char *cfg_file_name = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "b:w:i:sj:CncOo:g:")) != -1) {
+        switch (option) {
+            case 'b':
+                if (breakpoint_arg_count < TOTAL_INSTRUCTION_SLOTS) {
+                    breakpoint_args[breakpoint_arg_count++] = optarg;
+                }
+                break;
+            case 'w':
+                if (watchpoint_arg_count < TOTAL_WATCHPOINTS) {
+                    watchpoint_args[watchpoint_arg_count++] = optarg;
+                }
+                break;
+            case 'i':
+                for (variant = 0; variant < NUM_INTERPRETER_VARIANTS; variant++) {
+                    if (strcmp(optarg, interpreter_variant_names[variant]) == 0) {
+                        break;
+                    }
+                }
+                if (variant == NUM_INTERPRETER_VARIANTS) {
+                    printf("ERROR: Unknown interpreter '%s'. Expected fast, checked, traced or profiled.\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 's':
+                display_stats = true;
+                break;
+            case 'C':
+                use_cache = true;
+                break;
+            case 'n':
+                use_cache = false;
+                break;
+            case 'c':
+                clear_cache = true;
+                break;
+            case 'g':
+                cfg_file_name = optarg;
+                break;
+            case 'O':
+                optimize = true;
+                break;
+            case 'o':
+                object_file_name = optarg;
+                break;
+            case 'j':
+                num_threads = atoi(optarg);
+                if (num_threads < 1 || num_threads > MAX_ASSEMBLY_THREADS) {
+                    printf("ERROR: Number of assembler threads should be 1-%d.\n", MAX_ASSEMBLY_THREADS);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            default:
+                printf("Correct usage is <binary_name> [-i fast|checked|traced|profiled] [-s] [-j threads] [-C] [-n] [-c] [-O] [-g cfg_file] [-o object_file] [-b label|address]... [-w address]... [file_name|-|object_file...]\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind < argc - 1 && object_file_name != NULL) {
+        printf("Correct usage is <binary_name> [-i fast|checked|traced|profiled] [-s] [-j threads] [-C] [-n] [-c] [-O] [-g cfg_file] [-o object_file] [-b label|address]... [-w address]... [file_name|-|object_file...]\n");
+        exit(EXIT_FAILURE);
+    }
+    // Only the traced interpreter stops for the debugger.
+    if ((breakpoint_arg_count != 0 || watchpoint_arg_count != 0) && variant != INTERP_TRACED) {
+        printf("ERROR: Breakpoints and watchpoints need the traced interpreter.\n");
+        exit(EXIT_FAILURE);
+    }
+    initializeRegistersAndMemory();
 
-        // Parse command name.
-        int index_of_first_space = getIndexOfFirstChar(input, ' ');
+    // Read and execute assembly instructions from input file, or stdin if no
+    // file (or '-') is given.
+    struct source_buffer source;
+    openSourceBuffer(optind < argc ? argv[optind] : NULL, &source);
 
-        char command[10];
-        snprintf(command, index_of_first_space + 1, "%s", input);
+    PRINT_CHAR('=', 85); NEWLINE(1);
+    PRINT_CHAR('=', 85); NEWLINE(1);
+    printf("VALIDATING and DECODING INSTRUCTIONS\n");
+
+    // Object files are linked instead of assembled.
+    if (isObjectFile(&source)) {
+        if (object_file_name != NULL) {
+            printf("ERROR: '%s' is already an object file.\n", argv[optind]);
+            exit(EXIT_FAILURE);
+        }
+        closeSourceBuffer(&source);
+        linkObjectFiles(&argv[optind], argc - optind);
+    } else {
+        if (optind < argc - 1) {
+            printf("ERROR: Only object files can be linked; assemble each source file with -o first.\n");
+            exit(EXIT_FAILURE);
+        }
 
-        // This is special case of no operand instruction.
-        if (index_of_first_space == -1) {
-            snprintf(command, strlen(input) , "%s", input);
+        // Object files are assembled in a single pass, whose pending label fixups
+        // become the relocations. They are not cached.
+        if (object_file_name != NULL) {
+            use_cache = false;
+            num_threads = 1;
         }
 
-        if (!IsStringInStringArray(command, valid_instructions, 
-                    NUM_VALID_OPCODES)) {
-          printf("ERROR: Assembly Command '%s' not supported.\n", command);
-          exit(0);
+        // A program assembled before is loaded from the cache instead.
+        cache_results cache_result = use_cache ? CACHE_MISS : CACHE_BYPASS;
+        uint64_t source_hash = hashSource(source.data, source.size);
+        if (clear_cache) {
+            clearProgramCache();
         }
- 
-        // Parse out the arguments to command.
-        input = &input[index_of_first_space + 1];
-
-        char *args[10];
-        int arg_count = 0;
-        char *p = strtok (input, ",");
-        while (p != NULL) {
-            args[arg_count++] = p;
-            p = strtok (NULL, ",");
+        if (use_cache && loadProgramFromCache(&source, source_hash)) {
+            cache_result = CACHE_HIT;
+            printf("Loaded %d bytes of instructions and %d labels from the assembly cache.\n",
+                    (int) (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN), LABEL_COUNT);
+        } else {
+            if (num_threads > 1) {
+                assembleInParallel(&source, num_threads);
+            } else {
+                assembleInSinglePass(&source);
+            }
+
+            if (object_file_name != NULL) {
+                closeSourceBuffer(&source);
+                writeObjectFile(object_file_name);
+                exit(0);
+            }
+
+            // Every jump must have found its label by the end of the program.
+            if (FIXUP_COUNT != 0) {
+                printf("ERROR: Invalid label '%s' passed; does not match with any provided labels.\n",
+                        FIXUPS[0].label);
+                exit(0);
+            }
+
+            if (use_cache) {
+                saveProgramToCache(&source, source_hash);
+            }
         }
+        closeSourceBuffer(&source);
+        displayCacheStats(cache_result, source_hash);
+    }
 
-        if (index_of_first_space == -1) {
-            arg_count = 0;
+    // The traced interpreter displays the flags after every instruction, so
+    // only the others can skip flag updates.
+    if (optimize) {
+        optimizeInstructionMemory();
+        if (variant != INTERP_TRACED) {
+            analyzeFlagLiveness();
         }
-        validateEncodeAndSaveInstruction(instr_count - 2, command, args, arg_count);
     }
 
-    close(fp);
+    // The profiled interpreter exports the CFG with the execution counts once
+    // the program has run.
+    if (cfg_file_name != NULL && variant != INTERP_PROFILED) {
+        exportControlFlowGraph(cfg_file_name, false);
+    }
     
     NEWLINE(1);
     PRINT_CHAR('=', 85); NEWLINE(1);
     PRINT_CHAR('=', 85); NEWLINE(1);
     
+    // Set the requested breakpoints and watchpoints.
+    int i;
+    for (i = 0; i < breakpoint_arg_count; i++) {
+        if (!setBreakpoint(breakpoint_args[i], true)) {
+            exit(0);
+        }
+    }
+    for (i = 0; i < watchpoint_arg_count; i++) {
+        if (!setWatchpoint(watchpoint_args[i])) {
+            exit(0);
+        }
+    }
+
     printf("EXECUTING INSTRUCTIONS\n\n");
     // Decode the binary opcodes and execute the instructions.
-    decodeAndExecuteInstructions();
+    long long start_ns = getTimeInNanoseconds();
+    long executed_count = decodeAndExecuteInstructions(variant);
+    long long elapsed_ns = getTimeInNanoseconds() - start_ns;
+
+    // Only the traced interpreter displays the registers after every
+    // instruction, display the final state for the others.
+    if (variant != INTERP_TRACED) {
+        displayRegisters();
+    }
+    if (variant == INTERP_PROFILED) {
+        displayProfile(executed_count, elapsed_ns);
+        if (cfg_file_name != NULL) {
+            exportControlFlowGraph(cfg_file_name, true);
+        }
+    }
+    if (display_stats) {
+        displayExecutionStats(executed_count, elapsed_ns);
+        if (variant == INTERP_FAST) {
+            displayHotLoopStats();
+        }
+    }
 
     return 0;
 }
+#endif
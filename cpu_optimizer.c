@@ -0,0 +1,243 @@
+/*
+ * cpu_optimizer.c: Peephole optimizer over the assembled instruction memory.
+ *
+ * The optimizer removes instructions that have no effect:
+ *  - mov/cmovcc rX, rX
+ *  - addi $0, rX, when the next instruction overwrites all the flags it sets
+ *  - push rX directly followed by pop rX, except for the stack pointer
+ *  - jumps (conditional or not) to the next instruction
+ *
+ * The remaining instructions are moved up to close the gaps, and the label
+ * offsets of the control transfer instructions and the label positions are
+ * adjusted to the new layout. Removing instructions can expose new jumps to
+ * the next instruction, so passes are repeated until nothing changes.
+ */
+
+// One instruction of the program, with its extension words(if any).
+struct program_instruction {
+    int position;       // Instruction memory word of the instruction
+    int size;           // Number of words, including extension words
+    bool removed;
+    uint32_t binary_opcode;
+    struct instruction_attr instr_attr;
+};
+
+struct program_instruction PROGRAM_INSTRUCTIONS[TOTAL_INSTRUCTION_SLOTS];
+
+/*
+ * Returns true if executing the instruction overwrites every status flag.
+ * All Immediate-Type instructions and the R-Type instructions other than
+ * sltu/mult/multu set the flags from their result.
+ */
+bool
+writesAllFlags(struct instruction_attr *instr_attr_ptr) {
+    char *command = instr_attr_ptr->instruction;
+    if (IsStringInStringArray(command, I_INSTR, NUM_VALID_I_INSTR)) {
+        return true;
+    }
+    return IsStringInStringArray(command, R_INSTR, NUM_VALID_R_INSTR)
+        && strcmp(command, SLTU) != 0 && strcmp(command, MULT) != 0
+        && strcmp(command, MULTU) != 0;
+}
+
+/*
+ * Returns true for the jumps that only change the PC i.e. all control transfer
+ * instructions other than call and loop.
+ */
+bool
+isPlainJump(struct instruction_attr *instr_attr_ptr) {
+    return instr_attr_ptr->format == CONTROL_LABEL
+        && strcmp(instr_attr_ptr->instruction, CALL) != 0
+        && strcmp(instr_attr_ptr->instruction, LOOP) != 0;
+}
+
+/*
+ * Function to decode instruction memory into PROGRAM_INSTRUCTIONS. A zero
+ * word, which stops execution, is kept as a one word instruction. The
+ * per-word tables of the optimizer and the CFG hold TOTAL_INSTRUCTION_SLOTS
+ * words, so a larger program is rejected.
+ *
+ * Returns the number of instructions.
+ */
+int
+decodeProgramInstructions() {
+    int total_words = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    int count = 0;
+    if (total_words > TOTAL_INSTRUCTION_SLOTS) {
+        printf("ERROR: Program of %d words does not fit in instruction memory.\n", total_words);
+        exit(0);
+    }
+    int position = 0;
+    while (position < total_words) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[count++];
+        instr->position = position;
+        instr->size = 1;
+        instr->removed = false;
+        instr->binary_opcode = (uint32_t) readFromMemory(INSTRUCTION_MEMORY_MIN + position * INSTR_SIZE,
+                INSTR_SIZE);
+        memset(&instr->instr_attr, 0, sizeof(instr->instr_attr));
+        if (instr->binary_opcode != 0) {
+            decodeInstructionFromBinary(instr->binary_opcode, &instr->instr_attr);
+            if (instr->instr_attr.is_extended) {
+                instr->size += IMM_EXT_WORDS;
+            }
+        }
+        position += instr->size;
+    }
+    return count;
+}
+
+/*
+ * Returns the instruction memory word a control transfer instruction jumps to.
+ */
+int
+getJumpTarget(struct program_instruction *instr) {
+    return instr->position + 1 + instr->instr_attr.const_or_label;
+}
+
+/*
+ * Function to mark the instructions the peephole patterns remove. is_target
+ * marks the words that are jumped to or labelled.
+ *
+ * Returns the number of removed instructions.
+ */
+int
+markRemovableInstructions(int count, bool *is_target) {
+    int removed = 0;
+    int i;
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        struct instruction_attr *attr = &instr->instr_attr;
+        struct program_instruction *next = (i + 1 < count) ? &PROGRAM_INSTRUCTIONS[i + 1] : NULL;
+        if (instr->binary_opcode == 0) {
+            continue;
+        }
+
+        // mov/cmovcc rX, rX
+        if (attr->format == MOV_REG_REG && attr->operand_register == attr->base_register
+                && (strcmp(attr->instruction, MOV) == 0
+                    || IsStringInStringArray(attr->instruction, CMOV_INSTR, NUM_VALID_CMOV_INSTR))) {
+            instr->removed = true;
+        }
+        // addi $0, rX whose flags are never seen.
+        else if (attr->format == IMM_REG && !attr->is_extended && attr->const_or_label == 0
+                && strcmp(attr->instruction, ADDI) == 0
+                && next != NULL && next->binary_opcode != 0 && writesAllFlags(&next->instr_attr)) {
+            instr->removed = true;
+        }
+        // push rX; pop rX, unless something jumps to the pop.
+        else if (strcmp(attr->instruction, PUSH) == 0 && attr->operand_register != 14
+                && next != NULL && next->binary_opcode != 0 && !is_target[next->position]
+                && strcmp(next->instr_attr.instruction, POP) == 0
+                && next->instr_attr.operand_register == attr->operand_register) {
+            instr->removed = true;
+            next->removed = true;
+            removed++;
+            i++;
+        }
+        // Jump to the next instruction.
+        else if (isPlainJump(attr) && attr->const_or_label == 0) {
+            instr->removed = true;
+        }
+
+        if (instr->removed) {
+            removed++;
+        }
+    }
+    return removed;
+}
+
+/*
+ * Function to run one pass of the peephole optimizer over instruction memory.
+ *
+ * Returns the number of removed instructions.
+ */
+int
+runPeepholePass() {
+    int total_words = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    int count = decodeProgramInstructions();
+    int i;
+
+    // Words that execution can reach other than by falling through.
+    bool is_target[TOTAL_INSTRUCTION_SLOTS + 1] = {false};
+    for (i = 0; i < LABEL_COUNT; i++) {
+        if (LABELS[i].position >= 0 && LABELS[i].position <= total_words) {
+            is_target[LABELS[i].position] = true;
+        }
+    }
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        int target = getJumpTarget(instr);
+        if (instr->binary_opcode != 0 && instr->instr_attr.format == CONTROL_LABEL
+                && target >= 0 && target <= total_words) {
+            is_target[target] = true;
+        }
+    }
+
+    int removed = markRemovableInstructions(count, is_target);
+    if (removed == 0) {
+        return 0;
+    }
+
+    // New position of every old word. Removed instructions map to the next
+    // instruction that is kept.
+    int new_position[TOTAL_INSTRUCTION_SLOTS + 1];
+    int kept_words = 0;
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        int w;
+        for (w = 0; w < instr->size; w++) {
+            new_position[instr->position + w] = kept_words + (instr->removed ? 0 : w);
+        }
+        if (!instr->removed) {
+            kept_words += instr->size;
+        }
+    }
+    new_position[total_words] = kept_words;
+
+    // Copy the kept instructions into place, fixing up the label offsets.
+    unsigned char compacted[TOTAL_INSTRUCTION_SLOTS * INSTR_SIZE];
+    for (i = 0; i < count; i++) {
+        struct program_instruction *instr = &PROGRAM_INSTRUCTIONS[i];
+        if (instr->removed) {
+            continue;
+        }
+        unsigned char *dest = &compacted[new_position[instr->position] * INSTR_SIZE];
+        memcpy(dest, &MEMORY[INSTRUCTION_MEMORY_MIN + instr->position * INSTR_SIZE],
+                instr->size * INSTR_SIZE);
+
+        int target = getJumpTarget(instr);
+        if (instr->binary_opcode != 0 && instr->instr_attr.format == CONTROL_LABEL
+                && target >= 0 && target <= total_words) {
+            int label_offset = new_position[target] - new_position[instr->position] - 1;
+            uint32_t instruction = (instr->binary_opcode & ~0xffffu) | (label_offset & 0xffff);
+            memcpy(dest, &instruction, INSTR_SIZE);
+        }
+    }
+    memset(&MEMORY[INSTRUCTION_MEMORY_MIN], 0, total_words * INSTR_SIZE);
+    memcpy(&MEMORY[INSTRUCTION_MEMORY_MIN], compacted, kept_words * INSTR_SIZE);
+    INSTR_MEMORY_PTR = INSTRUCTION_MEMORY_MIN + kept_words * INSTR_SIZE;
+
+    for (i = 0; i < LABEL_COUNT; i++) {
+        if (LABELS[i].position >= 0 && LABELS[i].position <= total_words) {
+            LABELS[i].position = new_position[LABELS[i].position];
+        }
+    }
+    return removed;
+}
+
+/*
+ * Function to run the peephole optimizer until no more instructions can be
+ * removed, and report what it removed.
+ */
+void
+optimizeInstructionMemory() {
+    int initial_words = (INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE;
+    int total_removed = 0;
+    int removed;
+    while ((removed = runPeepholePass()) != 0) {
+        total_removed += removed;
+    }
+    printf("Peephole optimizer removed %d instructions (%d -> %d words).\n", total_removed,
+            initial_words, (int) ((INSTR_MEMORY_PTR - INSTRUCTION_MEMORY_MIN) / INSTR_SIZE));
+}
@@ -0,0 +1,209 @@
+/*
+ * cpu_packed.c: Packed (SIMD within a register) arithmetic on the general
+ * purpose registers, and vector load/store of 16-byte memory blocks.
+ *
+ * A register is treated as NUM_BYTES_IN_WORD 8-bit lanes or
+ * NUM_BYTES_IN_WORD / 2 16-bit lanes. Wrapping add/sub use carry-masking
+ * SWAR arithmetic. Saturating add/sub and compares use SSE2 intrinsics when
+ * the host has them, and fall back to a lane loop otherwise. Vector load/store
+ * move a block with a single unaligned SSE2 load/store.
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+void writeIntoMemory(SIZE_TYPE start_index, int num_bytes, data_ptr data);
+
+// Repeat a lane pattern across the width of a register.
+#define LANE_MASK_8     ((SIZE_TYPE) 0x8080808080808080ULL)
+#define LANE_MASK_16    ((SIZE_TYPE) 0x8000800080008000ULL)
+
+// Number of registers filled by a vector load/store.
+#define VECTOR_SIZE     16
+#define VECTOR_REGS     (VECTOR_SIZE / (NUM_BYTES_IN_WORD))
+
+typedef enum {LANE_ADD, LANE_SUB, LANE_ADDUS, LANE_SUBUS, LANE_CMPEQ, LANE_CMPGT} lane_operations;
+
+/*
+ * Wrapping lane-wise addition val2 + val1. The top bit of every lane is masked
+ * off so that carries do not cross into the next lane, and then added back
+ * with XOR.
+ */
+SIZE_TYPE
+packedAdd(SIZE_TYPE val1, SIZE_TYPE val2, SIZE_TYPE high_bits) {
+    SIZE_TYPE sum = (val1 & ~high_bits) + (val2 & ~high_bits);
+    return sum ^ ((val1 ^ val2) & high_bits);
+}
+
+/*
+ * Wrapping lane-wise subtraction val2 - val1. The top bit of every lane of
+ * val2 is set so that borrows do not cross into the next lane.
+ */
+SIZE_TYPE
+packedSubtract(SIZE_TYPE val1, SIZE_TYPE val2, SIZE_TYPE high_bits) {
+    SIZE_TYPE diff = (val2 | high_bits) - (val1 & ~high_bits);
+    return diff ^ ((val2 ^ ~val1) & high_bits);
+}
+
+/*
+ * Scalar fallback computing val2 op val1 on every lane of lane_bits bits.
+ */
+SIZE_TYPE
+packedLaneLoop(lane_operations operation, SIZE_TYPE val1, SIZE_TYPE val2, int lane_bits) {
+    SIZE_TYPE lane_max = (lane_bits == 8) ? 0xff : 0xffff;
+    SIZE_TYPE result = 0;
+    int shift;
+
+    for (shift = 0; shift < WORD_SIZE; shift += lane_bits) {
+        SIZE_TYPE a = (val2 >> shift) & lane_max;
+        SIZE_TYPE b = (val1 >> shift) & lane_max;
+        SIZE_TYPE lane = 0;
+        // Sign extend the lanes for signed compare.
+        long sa = (lane_bits == 8) ? (long) (signed char) a : (long) (short) a;
+        long sb = (lane_bits == 8) ? (long) (signed char) b : (long) (short) b;
+
+        switch (operation) {
+            case LANE_ADD:
+                lane = (a + b) & lane_max;
+                break;
+            case LANE_SUB:
+                lane = (a - b) & lane_max;
+                break;
+            case LANE_ADDUS:
+                lane = (a + b > lane_max) ? lane_max : a + b;
+                break;
+            case LANE_SUBUS:
+                lane = (a < b) ? 0 : a - b;
+                break;
+            case LANE_CMPEQ:
+                lane = (a == b) ? lane_max : 0;
+                break;
+            case LANE_CMPGT:
+                lane = (sa > sb) ? lane_max : 0;
+                break;
+        }
+        result = result | (lane << shift);
+    }
+    return result;
+}
+
+#if defined(__SSE2__)
+/*
+ * Move a register into the low lanes of an SSE register and back.
+ */
+static inline __m128i
+packedToVector(SIZE_TYPE value) {
+#if WORD_SIZE == 64
+    return _mm_cvtsi64_si128((long long) value);
+#else
+    return _mm_cvtsi32_si128((int) value);
+#endif
+}
+
+static inline SIZE_TYPE
+packedFromVector(__m128i value) {
+#if WORD_SIZE == 64
+    return (SIZE_TYPE) _mm_cvtsi128_si64(value);
+#else
+    return (SIZE_TYPE) _mm_cvtsi128_si32(value);
+#endif
+}
+#endif
+
+/*
+ * Function to compute val2 op val1 on every 8-bit (lane_bits = 8) or 16-bit
+ * (lane_bits = 16) lane of the registers.
+ */
+SIZE_TYPE
+packedOperation(lane_operations operation, SIZE_TYPE val1, SIZE_TYPE val2, int lane_bits) {
+    SIZE_TYPE high_bits = (lane_bits == 8) ? LANE_MASK_8 : LANE_MASK_16;
+
+    if (operation == LANE_ADD) {
+        return packedAdd(val1, val2, high_bits);
+    }
+    if (operation == LANE_SUB) {
+        return packedSubtract(val1, val2, high_bits);
+    }
+
+#if defined(__SSE2__)
+    __m128i a = packedToVector(val2);
+    __m128i b = packedToVector(val1);
+    __m128i r;
+    if (lane_bits == 8) {
+        switch (operation) {
+            case LANE_ADDUS: r = _mm_adds_epu8(a, b); break;
+            case LANE_SUBUS: r = _mm_subs_epu8(a, b); break;
+            case LANE_CMPEQ: r = _mm_cmpeq_epi8(a, b); break;
+            default:         r = _mm_cmpgt_epi8(a, b); break;
+        }
+    } else {
+        switch (operation) {
+            case LANE_ADDUS: r = _mm_adds_epu16(a, b); break;
+            case LANE_SUBUS: r = _mm_subs_epu16(a, b); break;
+            case LANE_CMPEQ: r = _mm_cmpeq_epi16(a, b); break;
+            default:         r = _mm_cmpgt_epi16(a, b); break;
+        }
+    }
+    return packedFromVector(r);
+#else
+    return packedLaneLoop(operation, val1, val2, lane_bits);
+#endif
+}
+
+/*
+ * Function to shuffle the bytes of val2 using the byte indices in val1. Result
+ * byte i is byte (val1[i] % NUM_BYTES_IN_WORD) of val2, or zero if the top bit
+ * of val1[i] is set.
+ */
+SIZE_TYPE
+packedShuffleBytes(SIZE_TYPE val1, SIZE_TYPE val2) {
+    SIZE_TYPE result = 0;
+    int i;
+    for (i = 0; i < NUM_BYTES_IN_WORD; i++) {
+        SIZE_TYPE control = (val1 >> (i * BYTE_SIZE)) & 0xff;
+        if (control & 0x80) {
+            continue;
+        }
+        SIZE_TYPE byte = (val2 >> ((control % NUM_BYTES_IN_WORD) * BYTE_SIZE)) & 0xff;
+        result = result | (byte << (i * BYTE_SIZE));
+    }
+    return result;
+}
+
+/*
+ * Function to load a 16-byte memory block into VECTOR_REGS consecutive
+ * registers starting at GPRS[reg]. The address must already be validated.
+ */
+void
+vectorLoad(int reg, SIZE_TYPE memory_address) {
+#if defined(__SSE2__)
+    // Memory and registers are both little endian on SSE2 hosts.
+    __m128i block = _mm_loadu_si128((const __m128i *) &MEMORY[memory_address]);
+    _mm_storeu_si128((__m128i *) &GPRS[reg], block);
+#else
+    int i;
+    for (i = 0; i < VECTOR_REGS; i++) {
+        GPRS[reg + i] = readFromMemory(memory_address + i * NUM_BYTES_IN_WORD, NUM_BYTES_IN_WORD);
+    }
+#endif
+}
+
+/*
+ * Function to store VECTOR_REGS consecutive registers starting at GPRS[reg]
+ * into a 16-byte memory block. The address must already be validated.
+ */
+void
+vectorStore(int reg, SIZE_TYPE memory_address) {
+#if defined(__SSE2__)
+    __m128i block = _mm_loadu_si128((const __m128i *) &GPRS[reg]);
+    _mm_storeu_si128((__m128i *) &MEMORY[memory_address], block);
+    notifyMemoryWrite(memory_address, VECTOR_SIZE);
+#else
+    int i;
+    for (i = 0; i < VECTOR_REGS; i++) {
+        writeIntoMemory(memory_address + i * NUM_BYTES_IN_WORD, NUM_BYTES_IN_WORD,
+                (data_ptr) &GPRS[reg + i]);
+    }
+#endif
+}
@@ -0,0 +1,88 @@
+/*
+ * cpu_profiler.c: Per-opcode execution counts collected by the profiled
+ * interpreter variant, and the execution statistics reported for benchmarks.
+ *
+ * Instructions are counted by their opcode and function field, so that the
+ * instructions sharing an opcode are reported separately, and by their
+ * address for the execution counts of the CFG export. The counting is only
+ * done by the profiled interpreter variant.
+ */
+
+#include <time.h>
+#include <sys/resource.h>
+
+// Key of an instruction is (opcode << 4) | function field.
+#define PROFILE_KEYS    (64 << 4)
+
+unsigned long PROFILE_COUNTS[PROFILE_KEYS];
+
+// Execution count of each instruction memory word.
+unsigned long PROFILE_ADDRESS_COUNTS[TOTAL_INSTRUCTION_SLOTS];
+
+/*
+ * Function to count one execution of the given binary instruction, found in
+ * the given instruction memory word.
+ */
+static inline void
+profileInstruction(SIZE_TYPE binary_opcode, SIZE_TYPE instr_slot) {
+    int opcode = (binary_opcode >> 26) & 0x3f;
+    int funct_shift = getFunctShift(opcode);
+    int funct = (funct_shift == -1) ? 0 : (binary_opcode >> funct_shift) & FUNCT_MASK;
+    PROFILE_COUNTS[(opcode << 4) | funct]++;
+    if (instr_slot < TOTAL_INSTRUCTION_SLOTS) {
+        PROFILE_ADDRESS_COUNTS[instr_slot]++;
+    }
+}
+
+/*
+ * Returns the current monotonic time in nanoseconds.
+ */
+long long
+getTimeInNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Function to display the execution counts of all executed instructions along
+ * with the total count and the execution time.
+ */
+void
+displayProfile(long instr_count, long long elapsed_ns) {
+    int i;
+    printf("\n------------------------------Instruction Profile------------------------------\n");
+    printf("Instruction \t : Count \t : Percentage\n");
+    printf("-------------------------------------------------------------------------------\n");
+    for (i = 0; i < TOTAL_ASSEMBLY_OPCODES; i++) {
+        unsigned long count = PROFILE_COUNTS[(opcode_map[i].opcode << 4) | opcode_map[i].funct];
+        if (count != 0) {
+            printf("%-10s \t : %lu \t : %6.2f%%\n", opcode_map[i].instruction, count,
+                    100.0 * count / instr_count);
+        }
+    }
+    printf("-------------------------------------------------------------------------------\n");
+    printf("Total instructions: %ld\n", instr_count);
+    printf("Execution time: %.3f ms\n", elapsed_ns / 1e6);
+    if (elapsed_ns > 0) {
+        printf("Instructions per second: %.0f\n", instr_count * 1e9 / elapsed_ns);
+    }
+    printf("-------------------------------------------------------------------------------\n\n");
+}
+
+/*
+ * Function to print the execution statistics as a single line of key=value
+ * pairs on stderr, for scripts collecting benchmark results.
+ */
+void
+displayExecutionStats(long instr_count, long long elapsed_ns) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(stderr, "instructions=%ld elapsed_ns=%lld ns_per_instruction=%.2f "
+            "instructions_per_second=%.0f peak_rss_kb=%ld\n",
+            instr_count, elapsed_ns,
+            instr_count > 0 ? (double) elapsed_ns / instr_count : 0.0,
+            elapsed_ns > 0 ? instr_count * 1e9 / elapsed_ns : 0.0,
+            usage.ru_maxrss);
+}
@@ -0,0 +1,71 @@
+/*
+ * cpu_shadow_stack.c: Host side shadow copy of the return addresses.
+ *
+ * call and ret still push/pop the return address on the stack in MEMORY, so
+ * the architectural stack is always correct, but they move it as one word
+ * instead of byte by byte. Every call also saves the return address and the
+ * stack slot it was pushed to on the shadow stack. The ret popping that slot
+ * checks the popped address against the shadow copy, and a difference, which
+ * means the program overwrote its return address, is reported.
+ *
+ * Programs can leave a function without ret (e.g. by resetting the SP), so the
+ * entries whose slot is already below the SP are dropped before matching.
+ */
+
+// One entry for each word of the stack memory, so a call never finds the
+// shadow stack full while the SP stays in the stack.
+#define SHADOW_STACK_DEPTH  ((MEMORY_SIZE - DATA_MEMORY_MAX) / NUM_BYTES_IN_WORD)
+
+struct shadow_return {
+    SIZE_TYPE return_address;
+    SIZE_TYPE stack_slot;
+};
+
+struct shadow_return SHADOW_STACK[SHADOW_STACK_DEPTH];
+int SHADOW_STACK_TOP = 0;
+
+// Number of ret instructions that popped an overwritten return address.
+long SHADOW_STACK_MISMATCHES = 0;
+
+/*
+ * Function to push the return address of a call onto the stack and the
+ * shadow stack.
+ */
+static inline void
+pushReturnAddress(SIZE_TYPE return_address) {
+    SP = SP - NUM_BYTES_IN_WORD;
+    memcpy(&MEMORY[SP], &return_address, NUM_BYTES_IN_WORD);
+    notifyMemoryWrite(SP, NUM_BYTES_IN_WORD);
+
+    if (SHADOW_STACK_TOP < SHADOW_STACK_DEPTH) {
+        SHADOW_STACK[SHADOW_STACK_TOP].return_address = return_address;
+        SHADOW_STACK[SHADOW_STACK_TOP].stack_slot = SP;
+        SHADOW_STACK_TOP++;
+    }
+}
+
+/*
+ * Function to pop the return address of a ret from the stack, and check it
+ * against the shadow stack.
+ *
+ * Returns the popped return address.
+ */
+static inline SIZE_TYPE
+popReturnAddress() {
+    SIZE_TYPE return_address;
+    memcpy(&return_address, &MEMORY[SP], NUM_BYTES_IN_WORD);
+
+    while (SHADOW_STACK_TOP > 0 && SHADOW_STACK[SHADOW_STACK_TOP - 1].stack_slot < SP) {
+        SHADOW_STACK_TOP--;
+    }
+    if (SHADOW_STACK_TOP > 0 && SHADOW_STACK[SHADOW_STACK_TOP - 1].stack_slot == SP) {
+        SIZE_TYPE expected = SHADOW_STACK[--SHADOW_STACK_TOP].return_address;
+        if (return_address != expected) {
+            SHADOW_STACK_MISMATCHES++;
+            printf("WARNING: Return address at 0x%" PRIxW " was overwritten. call pushed 0x%" PRIxW
+                    ", ret popped 0x%" PRIxW ".\n", SP, expected, return_address);
+        }
+    }
+    SP = SP + NUM_BYTES_IN_WORD;
+    return return_address;
+}
@@ -0,0 +1,204 @@
+/*
+ * cpu_source.c: Source input and tokenizer of the assembler.
+ *
+ * A source file is mapped read-only into memory and is never modified; input
+ * from a pipe is read into one buffer instead. Lines, labels, the command and
+ * its operands are returned as (pointer, length) tokens into that buffer. The
+ * tokenizer keeps all of its state in the caller's variables, so several
+ * threads can tokenize the same source at the same time.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MAX_OPERANDS        10
+#define MAX_OPERAND_LENGTH  100
+
+struct token {
+    const char *start;
+    int length;
+};
+
+struct source_buffer {
+    const char *data;
+    size_t size;
+    bool is_mapped;
+};
+
+/*
+ * Function to read the whole stream into a heap buffer, for input that cannot
+ * be mapped such as a pipe.
+ */
+void
+readSourceStream(int fd, struct source_buffer *source) {
+    size_t capacity = 4096;
+    size_t size = 0;
+    char *data = malloc(capacity);
+    ssize_t count;
+
+    while (data != NULL && (count = read(fd, data + size, capacity - size)) > 0) {
+        size += count;
+        if (size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    if (data == NULL || count < 0) {
+        printf("ERROR: File not available to read. \n");
+        exit(EXIT_FAILURE);
+    }
+    source->data = data;
+    source->size = size;
+    source->is_mapped = false;
+}
+
+/*
+ * Function to open the source program. A regular file is mapped into memory,
+ * anything else (stdin when file_name is NULL or "-") is read into a buffer.
+ */
+void
+openSourceBuffer(const char *file_name, struct source_buffer *source) {
+    int fd = STDIN_FILENO;
+    if (file_name != NULL && strcmp(file_name, "-") != 0) {
+        fd = open(file_name, O_RDONLY);
+        if (fd == -1) {
+            printf("ERROR: File not available to read. \n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+        void *data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            source->data = data;
+            source->size = file_stat.st_size;
+            source->is_mapped = true;
+        } else {
+            readSourceStream(fd, source);
+        }
+    } else {
+        readSourceStream(fd, source);
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+}
+
+void
+closeSourceBuffer(struct source_buffer *source) {
+    if (source->is_mapped) {
+        munmap((void *) source->data, source->size);
+    } else {
+        free((void *) source->data);
+    }
+}
+
+/*
+ * Function to get the next line of the source, without its line break.
+ * cursor points to the start of the unread source and is advanced past the
+ * line.
+ *
+ * Returns false at the end of the source.
+ */
+bool
+nextSourceLine(const char **cursor, const char *end, struct token *line) {
+    const char *pos = *cursor;
+    if (pos >= end) {
+        return false;
+    }
+    const char *line_end = memchr(pos, '\n', end - pos);
+    if (line_end == NULL) {
+        line_end = end;
+    }
+    line->start = pos;
+    line->length = line_end - pos;
+    *cursor = (line_end < end) ? line_end + 1 : end;
+    return true;
+}
+
+/*
+ * Function to remove leading and trailing white space from a token.
+ */
+void
+trimToken(struct token *tok) {
+    while (tok->length > 0 && isspace((unsigned char) tok->start[0])) {
+        tok->start++;
+        tok->length--;
+    }
+    while (tok->length > 0 && isspace((unsigned char) tok->start[tok->length - 1])) {
+        tok->length--;
+    }
+}
+
+/*
+ * Function to split a source line into its label, command and operands:
+ *  [label:] command [operand[, operand]...]
+ * A colon only ends a label when no space comes before it. Empty operands are
+ * skipped. The label has zero length when the line has none.
+ *
+ * Returns the number of operands, or -1 if there are more than MAX_OPERANDS.
+ */
+int
+tokenizeInstructionLine(struct token line, struct token *label, struct token *command,
+        struct token operands[MAX_OPERANDS]) {
+    const char *pos = line.start;
+    const char *end = line.start + line.length;
+
+    label->start = pos;
+    label->length = 0;
+    const char *colon = memchr(pos, ':', end - pos);
+    if (colon != NULL && memchr(pos, ' ', colon - pos) == NULL) {
+        label->length = colon - pos;
+        pos = colon + 1;
+    }
+
+    while (pos < end && isspace((unsigned char) *pos)) {
+        pos++;
+    }
+    command->start = pos;
+    while (pos < end && !isspace((unsigned char) *pos)) {
+        pos++;
+    }
+    command->length = pos - command->start;
+
+    int operand_count = 0;
+    while (pos < end) {
+        const char *comma = memchr(pos, ',', end - pos);
+        const char *operand_end = (comma != NULL) ? comma : end;
+        struct token operand = {pos, operand_end - pos};
+        trimToken(&operand);
+        if (operand.length > 0) {
+            if (operand_count == MAX_OPERANDS) {
+                return -1;
+            }
+            operands[operand_count++] = operand;
+        }
+        pos = (comma != NULL) ? comma + 1 : end;
+    }
+    return operand_count;
+}
+
+/*
+ * Function to copy a token into a null-terminated string of the given size,
+ * leaving out any white space inside it, e.g. "4(r1 + r2)" gives "4(r1+r2)".
+ *
+ * Returns false if the token does not fit.
+ */
+bool
+copyTokenWithoutSpaces(struct token tok, char *out, int size) {
+    int i, j = 0;
+    for (i = 0; i < tok.length; i++) {
+        if (isspace((unsigned char) tok.start[i])) {
+            continue;
+        }
+        if (j == size - 1) {
+            return false;
+        }
+        out[j++] = tok.start[i];
+    }
+    out[j] = '\0';
+    return true;
+}
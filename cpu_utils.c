@@ -72,7 +72,9 @@ bool isStartsWith(char* str, char* prefix) {
  */
 long getLongFromBaseTenOrHexString(char* str) {
     char* next;
-    long result = strtol(str, &next, 0);
+    // Parse as unsigned so that constants with the top bit of a 64-bit word set
+    // are not clamped.
+    long result = (long) strtoul(str, &next, 0);
     if (next == str || *next != '\0') {
         return -1;
     }
@@ -128,11 +130,50 @@ getOpcodeFromInstruction(char *command) {
 }
 
 
+/*
+ * Get function field corresponding to the instruction. Returns 0 for
+ * instructions which do not share their opcode.
+ */
+int
+getFunctFromInstruction(char *command) {
+  int i = 0;
+  for (i = 0; i < TOTAL_ASSEMBLY_OPCODES; i++) {
+      if (strcmp(command, opcode_map[i].instruction) == 0) {
+          return opcode_map[i].funct;
+      }
+  }
+  return 0;
+}
+
+/*
+ * Returns the position of the function field if the opcode is shared by a
+ * group of instructions, otherwise -1.
+ */
+int
+getFunctShift(int opcode) {
+    int i;
+    for (i = 0; i < NUM_FUNCT_OPCODES; i++) {
+        if (opcode == FUNCT_OPCODES[i].opcode) {
+            return FUNCT_OPCODES[i].shift;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Returns true if the opcode is shared by a group of instructions selected by
+ * the function field.
+ */
+bool
+isFunctOpcode(int opcode) {
+    return getFunctShift(opcode) != -1;
+}
+
 char *
-getInstructionFromOpcode(int opcode) {
+getInstructionFromOpcode(int opcode, int funct) {
     int i = 0;
     for (i = 0; i < TOTAL_ASSEMBLY_OPCODES; i++) {
-        if (opcode == opcode_map[i].opcode) {
+        if (opcode == opcode_map[i].opcode && funct == opcode_map[i].funct) {
             return opcode_map[i].instruction;
         }
     }
@@ -144,8 +185,13 @@ getInstructionFromOpcode(int opcode) {
 void
 decodeInstructionFromBinary(SIZE_TYPE binary_opcode, struct instruction_attr* instr_attr_ptr) {
     int opcode = (binary_opcode >> 26) & 0x3f;
+    int funct = 0;
+    int funct_shift = getFunctShift(opcode);
     char *command;
-    command = getInstructionFromOpcode(opcode);
+    if (funct_shift != -1) {
+        funct = (binary_opcode >> funct_shift) & FUNCT_MASK;
+    }
+    command = getInstructionFromOpcode(opcode, funct);
     
     // Get instruction attributes
     int op_reg = (binary_opcode >> 22) & 0x0f;
@@ -161,6 +207,7 @@ decodeInstructionFromBinary(SIZE_TYPE binary_opcode, struct instruction_attr* in
     instr_attr_ptr->index_register = index_reg;
     instr_attr_ptr->scale = scale;
     instr_attr_ptr->offset = (int) offset;
+    instr_attr_ptr->is_extended = false;
 
     // Memory-Type instructions
     if (IsStringInStringArray(command, MEM_INSTR, NUM_VALID_MEM_INSTR)) {
@@ -178,6 +225,7 @@ decodeInstructionFromBinary(SIZE_TYPE binary_opcode, struct instruction_attr* in
         // Imm-register type
         if (base_reg == 0) {
             instr_attr_ptr->format = IMM_REG;
+            instr_attr_ptr->is_extended = (binary_opcode >> IMM_EXT_SHIFT) & IMM_EXT_IND;
         } 
         // Imm-memory type
         else {
@@ -199,6 +247,10 @@ decodeInstructionFromBinary(SIZE_TYPE binary_opcode, struct instruction_attr* in
     else if (IsStringInStringArray(command, STACK_INSTR, NUM_VALID_STACK_INSTR)) {
         instr_attr_ptr->format = STACK_REG;
     }
+    // HI/LO move instructions
+    else if (IsStringInStringArray(command, HILO_INSTR, NUM_VALID_HILO_INSTR)) {
+        instr_attr_ptr->format = HILO_REG;
+    }
     // No operand instruction
     else if (IsStringInStringArray(command, NO_OPERAND_INSTR, NUM_VALID_NO_OPERAND_INSTR)) {
         instr_attr_ptr->format = NO_OPERAND;
@@ -209,6 +261,18 @@ decodeInstructionFromBinary(SIZE_TYPE binary_opcode, struct instruction_attr* in
         char label = binary_opcode & 0xff;
         instr_attr_ptr->const_or_label = (int) label;
     }
+    // Floating point instructions are register-register only
+    else if (IsStringInStringArray(command, FP_INSTR, NUM_VALID_FP_INSTR)) {
+        instr_attr_ptr->format = FP_REG_REG;
+    }
+    // Packed instructions are register-register only
+    else if (IsStringInStringArray(command, PACKED_INSTR, NUM_VALID_PACKED_INSTR)) {
+        instr_attr_ptr->format = REG_REG;
+    }
+    // Block memory instructions
+    else if (IsStringInStringArray(command, BLOCK_INSTR, NUM_VALID_BLOCK_INSTR)) {
+        instr_attr_ptr->format = BLOCK_REG;
+    }
     // Mov instructions
     else if (IsStringInStringArray(command, MOV_INSTR, NUM_VALID_MOV_INSTR)) {
         int indicator = (binary_opcode >> 16) & 0x01;
@@ -216,6 +280,7 @@ decodeInstructionFromBinary(SIZE_TYPE binary_opcode, struct instruction_attr* in
             instr_attr_ptr->format = MOV_IMM_REG;
             short label = binary_opcode & 0xffff;
             instr_attr_ptr->const_or_label = (int) label;
+            instr_attr_ptr->is_extended = (binary_opcode >> IMM_EXT_SHIFT) & IMM_EXT_IND;
         } else {
             instr_attr_ptr->format = MOV_REG_REG;
         }
@@ -230,6 +295,8 @@ encodeInstructionToBinary(struct instruction_attr *instr_attr_ptr) {
     
     char *instruction = instr_attr_ptr->instruction;
     int opcode = getOpcodeFromInstruction(instruction);
+    int funct = getFunctFromInstruction(instruction);
+    int funct_shift = getFunctShift(opcode);
     int base_reg = instr_attr_ptr->base_register;
     int index_reg = instr_attr_ptr->index_register;
     int offset = (instr_attr_ptr->offset & 0xff);
@@ -241,6 +308,9 @@ encodeInstructionToBinary(struct instruction_attr *instr_attr_ptr) {
     SIZE_TYPE binary_opcode;
     
     opcode = opcode << 26;
+    if (funct_shift != -1) {
+        opcode = opcode | (funct << funct_shift);
+    }
     op_reg = op_reg << 22;
     base_reg = base_reg << 18;
     index_reg = index_reg << 14;
@@ -275,8 +345,13 @@ encodeInstructionToBinary(struct instruction_attr *instr_attr_ptr) {
 
         case MEM_DISPLAY:
         case IMM_REG:
+            // Wide constants live in the extension word.
+            if (instr_attr_ptr->is_extended) {
+                indicator = IMM_EXT_IND << IMM_EXT_SHIFT;
+                label = 0;
+            }
             label = (label & 0xff);
-            binary_opcode = opcode | op_reg | label;
+            binary_opcode = opcode | op_reg | indicator | label;
             break;
 
         case IMM_MEM:
@@ -289,11 +364,13 @@ encodeInstructionToBinary(struct instruction_attr *instr_attr_ptr) {
             break;
 
         case CONTROL_LABEL:
+            // Operand register is only used by LOOP, it is 0 for jumps/calls.
             label = (label & 0xffff);
-            binary_opcode = opcode | label;
+            binary_opcode = opcode | op_reg | label;
             break;
 
         case STACK_REG:
+        case HILO_REG:
             binary_opcode = opcode | op_reg;
             break;
 
@@ -304,6 +381,11 @@ encodeInstructionToBinary(struct instruction_attr *instr_attr_ptr) {
 
         case MOV_IMM_REG:
             indicator = MOV_IMM_REG_IND << 16;
+            // Wide constants live in the extension word.
+            if (instr_attr_ptr->is_extended) {
+                indicator = indicator | (IMM_EXT_IND << IMM_EXT_SHIFT);
+                label = 0;
+            }
             label = label & 0xffff;
             binary_opcode = opcode | op_reg | indicator | label;
             break;
@@ -311,6 +393,14 @@ encodeInstructionToBinary(struct instruction_attr *instr_attr_ptr) {
         case NO_OPERAND:
             binary_opcode = opcode;
             break;
+
+        case BLOCK_REG:
+            binary_opcode = opcode | op_reg | base_reg | index_reg;
+            break;
+
+        case FP_REG_REG:
+            binary_opcode = opcode | op_reg | base_reg;
+            break;
     }
     return binary_opcode;
 }
@@ -337,7 +427,12 @@ storeLabelInformation(char* label, int position) {
     }
 
     if (LABEL_COUNT >= TOTAL_LABELS) {
-        printf("Instruction file cannot have more than %d labels.", TOTAL_LABELS);
+        printf("Instruction file cannot have more than %d labels.\n", TOTAL_LABELS);
+        exit(0);
+    }
+    if (strlen(label) >= sizeof(LABELS[0].label)) {
+        printf("Label '%s' is longer than %d characters.\n", label, (int) sizeof(LABELS[0].label) - 1);
+        exit(0);
     }
 
     LABELS[LABEL_COUNT].position = position;
@@ -349,3 +444,4 @@ storeLabelInformation(char* label, int position) {
     //printf("Stored '%s' at %d.\n", LABELS[LABEL_COUNT].label, LABELS[LABEL_COUNT].position);
     return LABEL_COUNT++;
 }
+
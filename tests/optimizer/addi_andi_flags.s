@@ -0,0 +1,8 @@
+movi $0, r1
+cmpi $0, r1
+movi $1, r2
+addi $0, r2
+andi $0, r3
+je yes
+movi $1, r4
+yes: movi $2, r5
@@ -0,0 +1,6 @@
+movi $5, r1
+cmpi $5, r1
+andi $0, r2
+je yes
+movi $1, r3
+yes: movi $2, r4
@@ -0,0 +1,28 @@
+#!/bin/sh
+##*****************************************************************************
+## Runs every program in tests/optimizer with the fast interpreter, with and
+## without -O, and checks that the registers, memory and flags displayed once
+## the program has run are the same. The final PC is not compared, as -O
+## removes instructions. Prints one line per program:
+##
+##   test=<name> status=ok|failed
+##
+## Usage: run_optimizer_tests.sh [simulator binary, default ./cpu]
+##*****************************************************************************
+
+CPU=${1:-./cpu}
+TEST_DIR=$(dirname "$0")/optimizer
+status=0
+
+for program in "$TEST_DIR"/*.s; do
+    name=$(basename "$program" .s)
+    plain=$("$CPU" -i fast "$program" 2>/dev/null | sed -n '/^EXECUTING INSTRUCTIONS/,$p' | grep -v '^PC')
+    optimized=$("$CPU" -i fast -O "$program" 2>/dev/null | sed -n '/^EXECUTING INSTRUCTIONS/,$p' | grep -v '^PC')
+    if [ -z "$plain" ] || [ "$plain" != "$optimized" ]; then
+        echo "test=$name status=failed"
+        status=1
+    else
+        echo "test=$name status=ok"
+    fi
+done
+exit $status